@@ -26,13 +26,125 @@
 #define EXEC_INSTRUCTION "/usr/bin/xterm"
 #define EXEC_ARGUMENTS "xterm", "-fa", "'Monospace'", "-fs", "12", "-hold", "-e", "python", "cf/python_exploration/cfs_cli.py"
 
-// Enable to get print messages for just about every remote function call
-#define VERBOSE 0
+// Launch attributes of the actual app, applied between fork and exec (see proxy_launch.h)
+// CPU mask: bit n allows CPU n, 0 inherits the affinity of the proxy task
+#define PROXY_CHILD_CPU_MASK 0
+// SCHED_OTHER, SCHED_FIFO or PROXY_LAUNCH_INHERIT, and the SCHED_FIFO priority
+#define PROXY_CHILD_SCHED_POLICY PROXY_LAUNCH_INHERIT
+#define PROXY_CHILD_SCHED_PRIORITY 0
+// Nice value (SCHED_OTHER only) or PROXY_LAUNCH_INHERIT
+#define PROXY_CHILD_NICE PROXY_LAUNCH_INHERIT
+// Let the app lock its memory: lifts RLIMIT_MEMLOCK and sets PROXY_MLOCKALL=1 for it
+#define PROXY_CHILD_MLOCKALL false
+// Address space limit (RLIMIT_AS) in bytes, 0 for no limit
+#define PROXY_CHILD_MEM_LIMIT 0
 
 // Timeout for NNG calls which are blocking such as nng_recv
 // Proxy calls nng_recv in the run loop, so this impacts responsiveness
 #define ACTUAL_NNG_TIMEOUT 500
 
+// How the free running loop waits for the actual app (see proxy_wait.c), can be changed
+// with PROXY_SET_WAIT_STRATEGY_CC. PROXY_WAIT_BLOCKING, PROXY_WAIT_BUSY_POLL or PROXY_WAIT_HYBRID.
+#define PROXY_WAIT_STRATEGY_DEFAULT PROXY_WAIT_BLOCKING
+
+// Bounds of the adaptive spin time of PROXY_WAIT_HYBRID before it blocks
+#define PROXY_WAIT_SPIN_MIN_US 10
+#define PROXY_WAIT_SPIN_MAX_US 2000
+
+// Scheduler driven mode: instead of spinning on the command pipe and nng_recv, the proxy
+// pends on PROXY_WAKEUP_MID (sent from the schedule table) and does its work in one bounded
+// slice per wakeup. Set to 0 for the free running loop.
+#define PROXY_SCHEDULED_MODE 0
+
+// How long to pend on the command pipe for a wakeup before checking RunLoop again
+#define PROXY_WAKEUP_TIMEOUT_MS 1000
+
+// Maximum number of remote calls serviced in one slice, and the time budget of a slice.
+// A slice that hits either limit is counted as an overrun.
+#define PROXY_SLICE_MSG_BUDGET 16
+#define PROXY_SLICE_TIME_BUDGET_US 5000
+
+// Send housekeeping every N wakeups (0 to only send on PROXY_SEND_HK_MID)
+#define PROXY_SLICE_HK_DIVISOR 0
+
+// The actual app is reported as timed out when no message has been received for this long
+#define PROXY_LIVENESS_TIMEOUT_MS 5000
+
 #define IPC_PIPE_ADDRESS "ipc://./cf/pair.ipc"
 
+// Hot handover (PROXY_HANDOVER_CC): the second endpoint, the actual app alternates between it
+// and IPC_PIPE_ADDRESS and is told which one in PROXY_IPC_ADDRESS. How long the replacement
+// has to send its first message, and the old app to exit once it has been switched out.
+#define PROXY_HANDOVER_ADDRESS "ipc://./cf/pair_handover.ipc"
+#define PROXY_HANDOVER_READY_MS 10000
+#define PROXY_HANDOVER_RETIRE_MS 2000
+
+// Largest message the proxy accepts from the actual app, offered in the capabilities exchange
+#define PROXY_MAX_MESSAGE_SIZE (64 * 1024)
+
+// Record mode (PROXY_RECORD_START_CC): default capture file, size of the in-memory ring
+// between the proxy task and the writer task, and the writer task settings
+#define PROXY_RECORD_FILE "./cf/proxy_capture.bin"
+#define PROXY_RECORD_RING_SIZE (1024 * 1024)
+#define PROXY_RECORD_STACK_SIZE 16384
+#define PROXY_RECORD_PRIORITY 200
+#define PROXY_RECORD_WRITER_DELAY_MS 10
+#define PROXY_RECORD_SHUTDOWN_TRIES 50
+
+// RPC trace (PROXY_TRACE_ENABLE_CC / PROXY_TRACE_DUMP_CC): whether tracing starts enabled,
+// number of calls kept in the trace ring, and the default dump file
+#define PROXY_TRACE_ENABLED_DEFAULT 0
+#define PROXY_TRACE_DEPTH 4096
+#define PROXY_TRACE_FILE "./cf/proxy_trace.json"
+// Perf markers of the actual app kept for the trace dump (PROXY_FEATURE_PERF_RING)
+#define PROXY_TRACE_MARKER_DEPTH 4096
+
+// Also add the perf markers drained from the actual app to the cFE perf log. They keep their
+// order there, but cFE stamps them when they are drained, not when the app hit them.
+#define PROXY_PERF_CFE_LOG 1
+
+// Tables the actual app can register through the proxy, and the prefix of the POSIX shared
+// memory objects holding their images (PROXY_SHM_PREFIX "_tbl_" <table name>)
+#define PROXY_MAX_TABLES 8
+#define PROXY_SHM_PREFIX "/proxy"
+
+// Critical Data Store blocks the actual app can register through the proxy
+#define PROXY_MAX_CDS 4
+
+// Worker pool servicing the remote calls, 0 services them on the proxy task. The workers
+// should run at or above the priority of the proxy task.
+#define PROXY_WORKER_POOL_SIZE 0
+#define PROXY_WORKER_QUEUE_DEPTH 32
+#define PROXY_WORKER_STACK_SIZE 32768
+#define PROXY_WORKER_PRIORITY 100
+#define PROXY_WORKER_ERROR_DELAY_MS 10
+#define PROXY_WORKER_SHUTDOWN_TRIES 50
+
+// Outbound queue for replies the actual app is not ready to take, and what to do when it is
+// full: PROXY_OUT_DROP the reply, or PROXY_OUT_RESTART the actual app
+#define PROXY_OUT_QUEUE_DEPTH 64
+#define PROXY_OUT_QUEUE_BYTES (256 * 1024)
+#define PROXY_OUT_OVERFLOW_POLICY PROXY_OUT_DROP
+
+// The state block of the shared statistics page is published at most this often
+#define PROXY_STATS_PUBLISH_MS 100
+
+// Resources used by the actual app are sampled this often. Limits on its CPU use (percent of
+// one CPU) and resident memory, 0 for none, can be changed with PROXY_SET_USAGE_LIMITS_CC.
+// A limit exceeded for PROXY_USAGE_SAMPLES_OVER samples in a row is reported, and with
+// PROXY_USAGE_RESTART the actual app is restarted (PROXY_USAGE_EVENT only reports).
+#define PROXY_USAGE_PERIOD_MS 1000
+#define PROXY_USAGE_CPU_PCT_MAX 0
+#define PROXY_USAGE_RSS_KB_MAX 0
+#define PROXY_USAGE_SAMPLES_OVER 5
+#define PROXY_USAGE_ACTION PROXY_USAGE_EVENT
+
+// AppID-by-name and reset type queries of the actual app are answered from a cache of this
+// many entries, 0 sends every query to ES; app and task info queries always go to ES. The
+// cache is emptied when ES reports an event, which arrive on a pipe of PROXY_ES_PIPE_DEPTH;
+// an entry is not used once it is older than PROXY_ES_CACHE_MAX_AGE_MS.
+#define PROXY_ES_CACHE_SIZE 16
+#define PROXY_ES_CACHE_MAX_AGE_MS 1000
+#define PROXY_ES_PIPE_DEPTH 32
+
 #endif /* proxy_defs_h */
@@ -15,5 +15,6 @@
 #define PROXY_CMD_MID           0x18A2
 #define PROXY_SEND_HK_MID       0x18A3
 #define PROXY_HK_TLM_MID        0x08A3
+#define PROXY_WAKEUP_MID        0x18A4
 
 #endif /* proxy_msgids_h */
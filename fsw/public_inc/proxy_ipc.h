@@ -0,0 +1,445 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_ipc_h
+#define proxy_ipc_h
+
+/*
+** Proxy control frames
+**
+** Besides the flatbuffer RemoteCall messages, the client and the proxy exchange small
+** fixed layout control frames on the same pair socket. A control frame starts with a
+** PROXY_CtrlHdr_t. A flatbuffer starts with the offset of its root table, which is always
+** smaller than the message, so a first word equal to PROXY_CTRL_MAGIC (larger than any
+** message the proxy accepts) can only be a control frame.
+**
+** All fields are in the byte order of the machine, both sides run on the same host.
+*/
+
+#include <stdint.h>
+
+#define PROXY_CTRL_MAGIC        0x31435850  /* "PXC1" */
+
+/* Version of the control frames and features below */
+#define PROXY_PROTOCOL_VERSION  1
+
+/* Control frame types */
+#define PROXY_CTRL_READY        1   /* client -> proxy, no reply */
+#define PROXY_CTRL_HELLO        2   /* client -> proxy, answered with PROXY_CTRL_CAPABILITIES */
+#define PROXY_CTRL_CAPABILITIES 3   /* proxy -> client */
+#define PROXY_CTRL_BATCH        4   /* client -> proxy, needs PROXY_FEATURE_BATCH */
+#define PROXY_CTRL_ERROR        5   /* proxy -> client, answers a frame the proxy can not handle */
+
+/* Table Services (PROXY_FEATURE_SHM_TABLES), all answered with PROXY_CTRL_TBL_REPLY */
+#define PROXY_CTRL_TBL_REGISTER         10
+#define PROXY_CTRL_TBL_LOAD             11
+#define PROXY_CTRL_TBL_GET_ADDRESS      12
+#define PROXY_CTRL_TBL_RELEASE_ADDRESS  13
+#define PROXY_CTRL_TBL_MANAGE           14
+#define PROXY_CTRL_TBL_REPLY            15
+
+/* Critical Data Store (PROXY_FEATURE_SHM_CDS), all answered with PROXY_CTRL_CDS_REPLY */
+#define PROXY_CTRL_CDS_REGISTER         20
+#define PROXY_CTRL_CDS_FLUSH            21
+#define PROXY_CTRL_CDS_RESTORE          22
+#define PROXY_CTRL_CDS_REPLY            23
+
+/* EVS filters evaluated by the client (PROXY_FEATURE_EVS_FILTER) */
+#define PROXY_CTRL_EVS_MAP              30  /* answered with PROXY_CTRL_EVS_REPLY */
+#define PROXY_CTRL_EVS_REPLY            31
+
+/* Perf markers written by the client (PROXY_FEATURE_PERF_RING) */
+#define PROXY_CTRL_PERF_MAP             40  /* answered with PROXY_CTRL_PERF_REPLY */
+#define PROXY_CTRL_PERF_REPLY           41
+
+/* ES queries answered from a cache (PROXY_FEATURE_ES_CACHE) */
+#define PROXY_CTRL_ES_QUERY             50  /* answered with PROXY_CTRL_ES_REPLY */
+#define PROXY_CTRL_ES_REPLY             51
+#define PROXY_CTRL_ES_MAP               52  /* answered with PROXY_CTRL_ES_MAP_REPLY */
+#define PROXY_CTRL_ES_MAP_REPLY         53
+
+/*
+** Optional features, negotiated with HELLO / CAPABILITIES. A feature may only be used
+** when it is set in the Features of the CAPABILITIES reply.
+*/
+#define PROXY_FEATURE_BATCH     0x00000001  /* several RemoteCalls in one PROXY_CTRL_BATCH frame */
+#define PROXY_FEATURE_COMPACT   0x00000002  /* reserved for a compact call encoding, not offered yet */
+#define PROXY_FEATURE_SHM_TABLES 0x00000004 /* cFE tables proxied, images shared read-only (PROXY_CTRL_TBL_*) */
+#define PROXY_FEATURE_SHM_CDS   0x00000008  /* CDS blocks proxied, mirrors shared read-write (PROXY_CTRL_CDS_*) */
+#define PROXY_FEATURE_EVS_FILTER 0x00000010 /* EVS binary filters shared with and evaluated by the client */
+#define PROXY_FEATURE_PERF_RING 0x00000020  /* perf markers written to a shared ring instead of PerfLogAdd calls */
+#define PROXY_FEATURE_ES_CACHE  0x00000040  /* ES queries (PROXY_CTRL_ES_*), replies may be kept by the client */
+
+/* Size of the supported function bitmap, one bit per Function_* union type */
+#define PROXY_FUNCTION_WORDS    8
+
+typedef struct
+{
+    uint32_t Magic;     /* PROXY_CTRL_MAGIC */
+    uint16_t Type;      /* PROXY_CTRL_* */
+    uint16_t Length;    /* Length of the whole frame, header included */
+} PROXY_CtrlHdr_t;
+
+/*
+** Length is 16 bits, so no control frame, batches included, may be longer than this. The
+** MaxMessageSize of the CAPABILITIES reply is never larger.
+*/
+#define PROXY_CTRL_MAX_LENGTH   65535
+
+/*
+** The reply to a control frame of an unknown type, or one that needs a feature that was not
+** negotiated, so the client fails at once instead of waiting for a reply that never comes.
+** A frame shorter than its type requires, or a batch with an entry that overruns the frame,
+** gets one with CFE_STATUS_WRONG_MSG_LENGTH in place of all its replies; none of the calls
+** of such a batch is run. READY has no reply, malformed or not. RemoteCalls in a well formed
+** batch that can not be serviced get a CFE_STATUS_NOT_IMPLEMENTED return each instead.
+*/
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    uint16_t        Type;               /* of the frame that failed */
+    uint16_t        Spare;
+    int32_t         Status;             /* CFE_STATUS_NOT_IMPLEMENTED, CFE_STATUS_WRONG_MSG_LENGTH */
+} PROXY_CtrlError_t;
+
+/*
+** Sent by the client once it has connected and finished its own initialization,
+** before its first RunLoop.
+*/
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    uint32_t        Pid;    /* getpid() of the client */
+} PROXY_CtrlReady_t;
+
+/*
+** Sent by the client right after it connects, before any RemoteCall.
+** Without a HELLO the proxy assumes the base protocol: RemoteCalls only, no features.
+*/
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    uint16_t        ProtocolVersion;    /* PROXY_PROTOCOL_VERSION of the client */
+    uint16_t        Spare;
+    uint32_t        Features;           /* PROXY_FEATURE_* the client can use */
+    uint32_t        MaxMessageSize;     /* largest message the client accepts, 0 for no limit */
+} PROXY_CtrlHello_t;
+
+/*
+** The proxy reply to HELLO. Features and MaxMessageSize are what both sides support.
+** Calls to functions not in the bitmap get an immediate CFE_STATUS_NOT_IMPLEMENTED reply.
+*/
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    uint16_t        ProtocolVersion;    /* PROXY_PROTOCOL_VERSION of the proxy */
+    uint16_t        Spare;
+    uint32_t        Features;
+    uint32_t        MaxMessageSize;
+    uint32_t        Functions[PROXY_FUNCTION_WORDS];    /* bit n set if Function_* type n is implemented */
+} PROXY_CtrlCapabilities_t;
+
+/*
+** A batch of RemoteCalls, serviced in order. The header is followed by Count entries, each a
+** PROXY_CtrlBatchEntry_t and the RemoteCall flatbuffer, padded to a multiple of
+** PROXY_BATCH_ALIGN bytes. Calls that have a reply get it as a separate message, as if
+** they had been sent one by one.
+*/
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    uint16_t        Count;
+    uint16_t        Spare;
+    uint32_t        Spare2;             /* keeps the first entry 8 byte aligned */
+} PROXY_CtrlBatch_t;
+
+typedef struct
+{
+    uint32_t        Length;             /* of the flatbuffer, without padding */
+    uint32_t        Spare;
+} PROXY_CtrlBatchEntry_t;
+
+#define PROXY_BATCH_ALIGN       8
+
+/*
+** Table Services
+**
+** The proxy registers and owns the table. Its image is shared with the client through a
+** read-only POSIX shared memory object (ShmName in the REGISTER reply), laid out as a
+** PROXY_ShmTbl_t followed by the image. The proxy refreshes the image whenever cFE reports
+** a validated and committed update, which it checks on MANAGE, on GET_ADDRESS and on each
+** housekeeping request.
+**
+** Reading the image without a copy:
+**     do {
+**         g = Generation (acquire);        -- odd while the proxy is copying, wait
+**         ... use the image ...
+**     } while (g is odd || Generation != g);
+** A client that only needs to know about updates polls Generation, there is no need to call
+** GET_ADDRESS. GET_ADDRESS and RELEASE_ADDRESS exist for code written against the cFE API.
+*/
+#define PROXY_TBL_NAME_LEN      40
+#define PROXY_SHM_NAME_LEN      64
+#define PROXY_PATH_LEN          64
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    char            Name[PROXY_TBL_NAME_LEN];
+    uint32_t        Size;               /* bytes of the table image */
+    uint16_t        Options;            /* CFE_TBL_OPT_* */
+    uint16_t        Spare;
+} PROXY_CtrlTblRegister_t;
+
+/*
+** Load a table from a file (SrcType CFE_TBL_SRC_FILE, Filename) or from an image that
+** follows this header (CFE_TBL_SRC_ADDRESS, DataLength equal to the registered size).
+*/
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    int32_t         Handle;
+    uint32_t        SrcType;            /* CFE_TBL_SRC_FILE or CFE_TBL_SRC_ADDRESS */
+    char            Filename[PROXY_PATH_LEN];
+    uint32_t        DataLength;
+    uint32_t        Spare;
+} PROXY_CtrlTblLoad_t;
+
+/* GET_ADDRESS, RELEASE_ADDRESS and MANAGE */
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    int32_t         Handle;
+    uint32_t        Spare;
+} PROXY_CtrlTblHandle_t;
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    int32_t         Status;             /* cFE status of the call (CFE_TBL_INFO_UPDATED etc.) */
+    int32_t         Handle;             /* valid after REGISTER */
+    uint32_t        Generation;         /* image generation after the call */
+    uint32_t        Size;
+    char            ShmName[PROXY_SHM_NAME_LEN];
+} PROXY_CtrlTblReply_t;
+
+typedef struct
+{
+    uint32_t        Generation;         /* odd while the image is being rewritten */
+    uint32_t        Size;               /* bytes of image that follow */
+    uint32_t        Loaded;             /* non-zero once an image has been copied in */
+    uint32_t        Spare;
+} PROXY_ShmTbl_t;
+
+/*
+** Critical Data Store
+**
+** The proxy registers and owns the CDS block. The client works on a read-write POSIX shared
+** memory mirror of the block (ShmName in the REGISTER reply, exactly Size bytes) and sends
+** FLUSH to have the proxy commit the mirror with CFE_ES_CopyToCDS. The client must not write
+** the mirror until the FLUSH reply arrives.
+**
+** On REGISTER of a block that survived a reset (Status CFE_ES_CDS_ALREADY_EXISTS), or that
+** was registered before by an earlier instance of the client, the mirror holds the last
+** committed contents and Restored is set. RESTORE rereads the committed contents on demand,
+** discarding what was written to the mirror since the last FLUSH.
+*/
+#define PROXY_CDS_NAME_LEN      16  /* CFE_MISSION_ES_CDS_MAX_NAME_LENGTH */
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    char            Name[PROXY_CDS_NAME_LEN];
+    uint32_t        Size;               /* bytes of the block */
+    uint32_t        Spare;
+} PROXY_CtrlCdsRegister_t;
+
+/* FLUSH and RESTORE */
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    int32_t         Handle;
+    uint32_t        Spare;
+} PROXY_CtrlCdsHandle_t;
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    int32_t         Status;             /* cFE status of the call */
+    int32_t         Handle;             /* valid after REGISTER */
+    uint32_t        Size;
+    uint32_t        Restored;           /* non-zero if the mirror holds committed contents */
+    char            ShmName[PROXY_SHM_NAME_LEN];
+} PROXY_CtrlCdsReply_t;
+
+/*
+** EVS filters
+**
+** With PROXY_FEATURE_EVS_FILTER the proxy keeps the filter table of the client's Register
+** call in a shared memory page (ShmName in the MAP reply) instead of giving it to EVS, so
+** events the filter suppresses are never sent. The proxy changes masks (ground command) and
+** clears counts (ResetFilter, ResetAllFilters) with the same generation protocol as the
+** table images; the client only updates Count. For each event the client does what EVS
+** would have done:
+**     find the entry of EventID, none means the event is sent
+**     do {
+**         c = Count;                       -- compare and swap, Count is shared
+**         send = (c & Mask) == 0;
+**     } while (c < PROXY_EVS_MAX_COUNT && !CAS(Count, c, c + 1));
+** reading Mask under the generation protocol. Events that pass are sent as usual.
+*/
+#define PROXY_EVS_MAX_FILTERS   8       /* CFE_PLATFORM_EVS_MAX_EVENT_FILTERS */
+#define PROXY_EVS_MAX_COUNT     65535   /* CFE_EVS_MAX_FILTER_COUNT, counts stop there */
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+} PROXY_CtrlEvsMap_t;
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    int32_t         Status;             /* CFE_SUCCESS, or the page is not available */
+    uint32_t        Spare;
+    char            ShmName[PROXY_SHM_NAME_LEN];
+} PROXY_CtrlEvsReply_t;
+
+typedef struct
+{
+    uint16_t        EventID;
+    uint16_t        Mask;               /* CFE_EVS_*_FILTER, written by the proxy */
+    uint16_t        Count;              /* updated by the client */
+    uint16_t        Spare;
+} PROXY_EvsFilter_t;
+
+typedef struct
+{
+    uint32_t          Generation;       /* odd while the proxy is changing the table */
+    uint32_t          NumFilters;
+    PROXY_EvsFilter_t Filters[PROXY_EVS_MAX_FILTERS];
+} PROXY_ShmEvs_t;
+
+/*
+** Perf markers
+**
+** With PROXY_FEATURE_PERF_RING the client writes CFE_ES_PerfLogAdd markers into a single
+** producer, single consumer ring in shared memory (ShmName in the MAP reply) instead of
+** sending a PerfLogAdd call for each, stamped with its own CLOCK_MONOTONIC time. The proxy
+** drains the ring in bulk. The client is the only writer of Head and Dropped, the proxy of
+** Tail:
+**     h = Head; t = load_acquire(Tail);
+**     if (h - t == PROXY_PERF_RING_ENTRIES) { Dropped++; return; }
+**     Markers[h % PROXY_PERF_RING_ENTRIES] = { now, Marker, EntryExit };
+**     store_release(Head, h + 1);
+** The client starts from the Head it finds, a ring may have been written by an earlier
+** instance of the client.
+*/
+#define PROXY_PERF_RING_ENTRIES 4096    /* power of two */
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+} PROXY_CtrlPerfMap_t;
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    int32_t         Status;             /* CFE_SUCCESS, or the ring is not available */
+    uint32_t        Entries;            /* PROXY_PERF_RING_ENTRIES */
+    char            ShmName[PROXY_SHM_NAME_LEN];
+} PROXY_CtrlPerfReply_t;
+
+typedef struct
+{
+    uint64_t        TimeNs;             /* CLOCK_MONOTONIC of the client when the marker was hit */
+    uint32_t        Marker;
+    uint32_t        EntryExit;          /* 0 entry, 1 exit, as for CFE_ES_PerfLogAdd */
+} PROXY_PerfMarker_t;
+
+typedef struct
+{
+    uint32_t           Head;            /* markers written, by the client */
+    uint32_t           Dropped;         /* markers lost to a full ring, by the client */
+    uint32_t           Spare1[14];      /* keeps Head and Tail on separate cache lines */
+    uint32_t           Tail;            /* markers drained, by the proxy */
+    uint32_t           Spare2[15];
+    PROXY_PerfMarker_t Markers[PROXY_PERF_RING_ENTRIES];
+} PROXY_ShmPerf_t;
+
+/*
+** ES queries
+**
+** With PROXY_FEATURE_ES_CACHE the client asks for CFE_ES_GetAppIDByName (Name),
+** CFE_ES_GetAppInfo (Id is the AppId), CFE_ES_GetTaskInfo (Id is the TaskId) and
+** CFE_ES_GetResetType with a QUERY frame. The proxy answers APP_ID_BY_NAME and RESET_TYPE
+** from its cache, which it empties whenever ES reports an event (an app was started, stopped,
+** restarted or reloaded), so the reply is what the call would have returned, give or take
+** MaxAgeMs. APP_INFO and TASK_INFO hold counters that change without an event of ES
+** (ExecutionCounter, NumOfChildTasks), so they are always asked of ES and never have Cached
+** set. Info holds the CFE_ES_AppInfo_t or CFE_ES_TaskInfo_t of the proxy's cFE build,
+** InfoSize bytes of it; the reply frame ends there.
+**
+** The client may keep APP_ID_BY_NAME and RESET_TYPE replies too (ShmName in the MAP reply,
+** mapped read-only), but not APP_INFO or TASK_INFO ones. A kept reply answers the same query
+** locally while
+**     load_acquire(Page->Generation) == Reply.Generation
+** and it is younger than Page->MaxAgeMs, otherwise the query goes to the proxy again.
+*/
+#define PROXY_ES_APP_ID_BY_NAME 1
+#define PROXY_ES_APP_INFO       2
+#define PROXY_ES_TASK_INFO      3
+#define PROXY_ES_RESET_TYPE     4
+
+#define PROXY_ES_NAME_LEN       20      /* OS_MAX_API_NAME */
+#define PROXY_ES_INFO_LEN       512     /* room for CFE_ES_AppInfo_t and CFE_ES_TaskInfo_t */
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    uint16_t        Query;              /* PROXY_ES_* */
+    uint16_t        Spare;
+    uint32_t        Id;                 /* AppId or TaskId as an integer */
+    char            Name[PROXY_ES_NAME_LEN];    /* APP_ID_BY_NAME, need not be terminated */
+} PROXY_CtrlEsQuery_t;
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    uint16_t        Query;
+    uint16_t        Cached;             /* 1 when answered from the cache */
+    int32_t         Status;             /* of the cFE call, CFE_STATUS_NOT_IMPLEMENTED without the feature */
+    uint32_t        Id;                 /* APP_ID_BY_NAME: the AppId as an integer */
+    uint32_t        ResetSubtype;       /* RESET_TYPE: the subtype, Status is the reset type */
+    uint32_t        Generation;         /* of the cache the reply came from */
+    uint32_t        InfoSize;           /* APP_INFO and TASK_INFO */
+    uint8_t         Info[PROXY_ES_INFO_LEN];
+} PROXY_CtrlEsReply_t;
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+} PROXY_CtrlEsMap_t;
+
+typedef struct
+{
+    PROXY_CtrlHdr_t Hdr;
+    int32_t         Status;             /* CFE_SUCCESS, or the page is not available */
+    uint32_t        Spare;
+    char            ShmName[PROXY_SHM_NAME_LEN];
+} PROXY_CtrlEsMapReply_t;
+
+typedef struct
+{
+    uint32_t        Generation;         /* changes whenever the cache is emptied, by the proxy */
+    uint32_t        MaxAgeMs;           /* longest a reply may be kept */
+} PROXY_ShmEs_t;
+
+#endif /* proxy_ipc_h */
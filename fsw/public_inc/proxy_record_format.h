@@ -0,0 +1,47 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_record_format_h
+#define proxy_record_format_h
+
+/*
+** Capture file format written by the proxy record mode and read by tools/proxy_replay.
+**
+** The file starts with a PROXY_RecordFileHdr_t, followed by records. Each record is a
+** PROXY_RecordHdr_t followed by Length bytes: the raw flatbuffer as it crossed the IPC.
+** All fields are in the byte order of the machine the proxy ran on.
+*/
+
+#include <stdint.h>
+
+#define PROXY_RECORD_MAGIC      0x43525850  /* "PXRC" */
+#define PROXY_RECORD_VERSION    2
+
+/* Record kinds */
+#define PROXY_RECORD_REQUEST    1   /* RemoteCall received from the actual app */
+#define PROXY_RECORD_REPLY      2   /* ReturnData sent back to the actual app */
+
+typedef struct
+{
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t Spare;
+} PROXY_RecordFileHdr_t;
+
+typedef struct
+{
+    uint32_t Length;    /* payload bytes following this header */
+    uint16_t Kind;
+    uint16_t Replies;   /* REQUEST: replies the proxy sends for it (0 for void calls, n for a batch) */
+    uint64_t TimeNs;    /* CLOCK_MONOTONIC of the proxy */
+} PROXY_RecordHdr_t;
+
+#endif /* proxy_record_format_h */
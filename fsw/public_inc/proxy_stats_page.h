@@ -0,0 +1,88 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_stats_page_h
+#define proxy_stats_page_h
+
+/*
+** Statistics page kept by the proxy in POSIX shared memory (PROXY_SHM_PREFIX "_stats",
+** "/proxy_stats" by default) and read by tools/proxy_stat or any other monitor, at any rate
+** and without the Software Bus.
+**
+** The counters are updated in place as calls are serviced, each with a relaxed atomic
+** operation, so a reader sees every counter move forward but not all of them at the same
+** instant. The state block is published by the proxy task a few times a second under a
+** sequence lock:
+**     do {
+**         s = Sequence (acquire);          -- odd while the proxy is publishing, retry
+**         ... copy the state block ...
+**     } while (s is odd || Sequence != s);
+** A reader must check Magic, Version and Size before trusting the layout. Times are
+** CLOCK_MONOTONIC in ns, the reader runs on the same host and can take the age of LastMsgNs
+** against its own clock.
+*/
+
+#include <stdint.h>
+
+#define PROXY_STATS_MAGIC           0x54535850  /* "PXST" */
+#define PROXY_STATS_VERSION         1
+
+/* Latency bucket n counts calls that took less than 2^n us, the last one the rest */
+#define PROXY_STATS_LATENCY_BUCKETS 16
+
+/* ChildState */
+#define PROXY_STATS_CHILD_UNKNOWN   1
+#define PROXY_STATS_CHILD_RUNNING   2
+#define PROXY_STATS_CHILD_TIMED_OUT 3
+#define PROXY_STATS_CHILD_EXITED    4
+
+typedef struct
+{
+    /* Written once when the page is created */
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t Size;                  /* sizeof(PROXY_StatsPage_t) */
+    uint32_t ProxyPid;
+    uint32_t Spare;
+
+    /* Counters, relaxed atomic updates */
+    uint64_t Messages;              /* messages received from the actual app */
+    uint64_t Calls;                 /* remote calls serviced */
+    uint64_t CtrlFrames;            /* control frames serviced */
+    uint64_t Replies;               /* replies sent or queued */
+    uint64_t ReplyErrors;           /* replies nng refused */
+    uint64_t LastMsgNs;             /* when the last message was received */
+    uint64_t LatencyCount;          /* calls timed, receive to reply (or to the end of a void call) */
+    uint64_t LatencySumNs;
+    uint64_t LatencyMaxNs;
+    uint64_t LatencyHist[PROXY_STATS_LATENCY_BUCKETS];
+
+    /* State block, published under Sequence */
+    uint32_t Sequence;
+    uint32_t Spare2;
+    uint64_t PublishNs;             /* when the state block was last published */
+    int32_t  ChildPid;
+    int32_t  ChildState;            /* PROXY_STATS_CHILD_* */
+    uint32_t ChildRestarts;
+    int32_t  LaunchStage;           /* stage of a failed launch, 0 if none */
+    int32_t  ForkError;             /* errno of a failed launch */
+    int32_t  NngError;              /* last nng error */
+    int32_t  OutError;              /* last failed queued send */
+    uint32_t CommandCount;
+    uint32_t CommandErrors;
+    uint32_t OutQueuedBytes;
+    uint32_t OutHighWater;
+    uint32_t OutDrops;
+    uint32_t PoolDepth;
+    uint32_t PoolDepthMax;
+} PROXY_StatsPage_t;
+
+#endif /* proxy_stats_page_h */
@@ -31,8 +31,24 @@
 #include "proxy_events.h"
 #include "proxy_version.h"
 #include "proxy_defs.h"
+#include "proxy_record.h"
+#include "proxy_trace.h"
+#include "proxy_wait.h"
+#include "proxy_launch.h"
+#include "proxy_ctrl.h"
+#include "proxy_tbl.h"
+#include "proxy_cds.h"
+#include "proxy_pool.h"
+#include "proxy_evs.h"
+#include "proxy_out.h"
+#include "proxy_stats.h"
+#include "proxy_handover.h"
+#include "proxy_perf.h"
+#include "proxy_usage.h"
+#include "proxy_es.h"
 
 #include <signal.h>
+#include <sys/wait.h>
 
 #include <nng/nng.h>
 #include <nng/protocol/pair0/pair.h>
@@ -61,6 +77,15 @@ CFE_MSG_Message_t *    PROXY_MsgPtr;
 
 nng_socket sock;
 
+// Context of the calls and control frames serviced on the proxy task
+PROXY_CallCtx_t PROXY_MainCtx = { .Builder = &builder };
+
+// Monotonic time of the last message from the actual app, for the liveness check
+uint64 PROXY_LastMsgNs;
+
+// Startup phase times
+PROXY_Startup_t PROXY_Startup;
+
 pid_t childPID;
 
 // APP ID for the proxy event app
@@ -89,6 +114,30 @@ void PROXY_Main( void )
     // Main run loop
     while (CFE_ES_RunLoop(&RunStatus) == true)
     {
+        if (PROXY_OutRestartRequested())
+        {
+            PROXY_RestartChild();
+        }
+        PROXY_HandoverPoll();
+        PROXY_PerfDrain();
+        PROXY_StatsPublish();
+        PROXY_UsageSample();
+        PROXY_EsPoll();
+
+        if (PROXY_SCHEDULED_MODE)
+        {
+            // All of the work happens in PROXY_RunSlice when the wakeup arrives on the command pipe
+            CFE_ES_PerfLogExit(PROXY_PERF_ID);
+            status = CFE_SB_ReceiveBuffer((CFE_SB_Buffer_t **)&PROXY_MsgPtr,  PROXY_CommandPipe,  PROXY_WAKEUP_TIMEOUT_MS);
+            CFE_ES_PerfLogEntry(PROXY_PERF_ID);
+
+            if (status == CFE_SUCCESS)
+            {
+                PROXY_ProcessCommandPacket();
+            }
+            continue;
+        }
+
         // Two parts: check for proxy commands and check for messages from the actual app
 
         status = CFE_SB_ReceiveBuffer((CFE_SB_Buffer_t **)&PROXY_MsgPtr,  PROXY_CommandPipe,  CFE_SB_POLL);
@@ -100,7 +149,7 @@ void PROXY_Main( void )
             PROXY_ProcessCommandPacket();
         }
 
-        incoming_message();
+        PROXY_WaitAndService();
     }
 
     // The App has been killed
@@ -108,38 +157,122 @@ void PROXY_Main( void )
     // TODO: Actual timeout...
     int the_final_countdown = 6;
     while(the_final_countdown--) {
-        incoming_message();
+        incoming_message(0);
     }
 
     CFE_EVS_SendEventWithAppID(PROXY_SHUTDOWN_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
                                "Pro Proxy Shutdown");
-    kill(childPID, SIGKILL);
+    // childPID is -1 after a failed launch, and kill(-1) would signal every process
+    if (childPID > 0)
+    {
+        kill(childPID, SIGKILL);
+    }
 
     cleanup_and_exit(RunStatus);
 } /* End of PROXY_Main() */
 
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_RestartChild                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Kills the actual app, drops the replies queued for it and launches */
+/*         it again. The socket keeps listening for the new instance.         */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_RestartChild(void)
+{
+    uint32 dropped;
+
+    PROXY_HandoverAbort("the actual app is restarting");
+
+    if (childPID > 0)
+    {
+        kill(childPID, SIGKILL);
+        waitpid(childPID, NULL, 0);
+    }
+
+    // pair0 has no correlation IDs: a reply a worker sends for the old instance would be
+    // taken by the new one as the answer to its own call. Let the workers finish first, then
+    // drop whatever they queued.
+    PROXY_PoolWaitAll();
+    dropped = PROXY_OutReset();
+
+    CFE_EVS_SendEventWithAppID(PROXY_RESTART_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: restarting the actual app, %u replies dropped", (unsigned int) dropped);
+
+    // The new instance negotiates again, nothing of the old one carries over
+    PROXY_CtrlReset(&PROXY_Ctrl);
+
+    childPID = PROXY_LaunchChild(&PROXY_LaunchAttr);
+    PROXY_LaunchReportError();
+
+    PROXY_HkTelemetryPkt.actual_run_state = ACTUAL_STATE_UNKOWN;
+    PROXY_HkTelemetryPkt.actual_reset_count++;
+    PROXY_LastMsgNs = PROXY_MonotonicNs();
+} /* End of PROXY_RestartChild() */
+
 void cleanup_and_exit( uint32 RunStatus )
 {
     PROXY_ReportHousekeeping();
 
+    // The workers may still be replying and recording
+    PROXY_PoolShutdown();
+
+    // Let the recorder flush the capture
+    PROXY_RecordShutdown();
+    PROXY_TblCleanup();
+    PROXY_CdsCleanup();
+    PROXY_EvsCleanup();
+    PROXY_PerfCleanup();
+    PROXY_StatsCleanup();
+    PROXY_UsageCleanup();
+    PROXY_EsCleanup();
+
     // Clean up flatcc
     flatcc_builder_clear(&builder);
 
-    // Clean up nng
+    // Clean up nng, the replacement or the old app of a handover goes too
+    PROXY_HandoverCleanup();
     nng_close(sock);
+    PROXY_OutCleanup();
 
     CFE_ES_ExitApp(RunStatus);
 }
 
+// Sends a finalized reply from the proxy task, caller is used in the error event
+void send_reply(const char *caller, void *flat_buffer, size_t size)
+{
+    send_call_reply(&PROXY_MainCtx, caller, flat_buffer, size);
+}
+
+// Sends a finalized reply to the origin of the call being serviced
+void send_call_reply(PROXY_CallCtx_t *Ctx, const char *caller, void *flat_buffer, size_t size)
+{
+    int rv;
+
+    // Never blocks, a reply the actual app is not ready for is queued
+    rv = PROXY_OutSend(Ctx->Sock, flat_buffer, size);
+    PROXY_TraceReplySent(&Ctx->Trace);
+    PROXY_StatsCount(rv == 0 ? &PROXY_Stats->Replies : &PROXY_Stats->ReplyErrors);
+    if (rv != 0)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                  "Proxy %s - NNG error: %s", caller, nng_strerror(rv));
+        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
+    }
+
+    PROXY_RecordFrame(PROXY_RECORD_REPLY, flat_buffer, size);
+}
+
 // None of the function arguments need to be returned
 // Does send a single int32 as the return of the function
-void return_regular_int32(int32 call_return)
+void return_regular_int32(PROXY_CallCtx_t *Ctx, int32 call_return)
 {
     size_t size;
-    int rv;
     void *flat_buffer;
     // Send the return value
-    flatcc_builder_t *B = &builder;
+    flatcc_builder_t *B = Ctx->Builder;
+
+    PROXY_TraceCallDone(&Ctx->Trace);
 
     nsr(Empty_ref_t) empty = nsr(Empty_create(B));
     nsr(PointerReturn_union_ref_t) output = nsr(PointerReturn_as_Empty(empty));
@@ -148,13 +281,7 @@ void return_regular_int32(int32 call_return)
     nsr(ReturnData_create_as_root(B, retval, output));
 
     flat_buffer = flatcc_builder_finalize_aligned_buffer(B, &size);
-    rv = nng_send(sock, flat_buffer, size, 0);
-    if (rv != 0)
-    {
-        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - NNG error: %s", __func__, nng_strerror(rv));
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
-    }
+    send_call_reply(Ctx, __func__, flat_buffer, size);
 
     flatcc_builder_aligned_free(flat_buffer);
     /*
@@ -164,13 +291,14 @@ void return_regular_int32(int32 call_return)
     flatcc_builder_reset(B);
 }
 
-void return_regular_uint32(uint32 call_return)
+void return_regular_uint32(PROXY_CallCtx_t *Ctx, uint32 call_return)
 {
     size_t size;
-    int rv;
     void *flat_buffer;
     // Send the return value
-    flatcc_builder_t *B = &builder;
+    flatcc_builder_t *B = Ctx->Builder;
+
+    PROXY_TraceCallDone(&Ctx->Trace);
 
     nsr(Empty_ref_t) empty = nsr(Empty_create(B));
     nsr(PointerReturn_union_ref_t) output = nsr(PointerReturn_as_Empty(empty));
@@ -179,13 +307,7 @@ void return_regular_uint32(uint32 call_return)
     nsr(ReturnData_create_as_root(B, retval, output));
 
     flat_buffer = flatcc_builder_finalize_aligned_buffer(B, &size);
-    rv = nng_send(sock, flat_buffer, size, 0);
-    if (rv != 0)
-    {
-        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - NNG error: %s", __func__, nng_strerror(rv));
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
-    }
+    send_call_reply(Ctx, __func__, flat_buffer, size);
 
     flatcc_builder_aligned_free(flat_buffer);
     /*
@@ -195,13 +317,14 @@ void return_regular_uint32(uint32 call_return)
     flatcc_builder_reset(B);
 }
 
-void return_regular_int16(int16 call_return)
+void return_regular_int16(PROXY_CallCtx_t *Ctx, int16 call_return)
 {
     size_t size;
-    int rv;
     void *flat_buffer;
     // Send the return value
-    flatcc_builder_t *B = &builder;
+    flatcc_builder_t *B = Ctx->Builder;
+
+    PROXY_TraceCallDone(&Ctx->Trace);
 
     nsr(Empty_ref_t) empty = nsr(Empty_create(B));
     nsr(PointerReturn_union_ref_t) output = nsr(PointerReturn_as_Empty(empty));
@@ -210,13 +333,7 @@ void return_regular_int16(int16 call_return)
     nsr(ReturnData_create_as_root(B, retval, output));
 
     flat_buffer = flatcc_builder_finalize_aligned_buffer(B, &size);
-    rv = nng_send(sock, flat_buffer, size, 0);
-    if (rv != 0)
-    {
-        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - NNG error: %s", __func__, nng_strerror(rv));
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
-    }
+    send_call_reply(Ctx, __func__, flat_buffer, size);
 
     flatcc_builder_aligned_free(flat_buffer);
     /*
@@ -226,13 +343,14 @@ void return_regular_int16(int16 call_return)
     flatcc_builder_reset(B);
 }
 
-void return_regular_uint16(uint16 call_return)
+void return_regular_uint16(PROXY_CallCtx_t *Ctx, uint16 call_return)
 {
     size_t size;
-    int rv;
     void *flat_buffer;
     // Send the return value
-    flatcc_builder_t *B = &builder;
+    flatcc_builder_t *B = Ctx->Builder;
+
+    PROXY_TraceCallDone(&Ctx->Trace);
 
     nsr(Empty_ref_t) empty = nsr(Empty_create(B));
     nsr(PointerReturn_union_ref_t) output = nsr(PointerReturn_as_Empty(empty));
@@ -241,13 +359,7 @@ void return_regular_uint16(uint16 call_return)
     nsr(ReturnData_create_as_root(B, retval, output));
 
     flat_buffer = flatcc_builder_finalize_aligned_buffer(B, &size);
-    rv = nng_send(sock, flat_buffer, size, 0);
-    if (rv != 0)
-    {
-        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - NNG error: %s", __func__, nng_strerror(rv));
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
-    }
+    send_call_reply(Ctx, __func__, flat_buffer, size);
 
     flatcc_builder_aligned_free(flat_buffer);
     /*
@@ -257,13 +369,14 @@ void return_regular_uint16(uint16 call_return)
     flatcc_builder_reset(B);
 }
 
-void return_regular_cFETime(CFE_TIME_SysTime_t time)
+void return_regular_cFETime(PROXY_CallCtx_t *Ctx, CFE_TIME_SysTime_t time)
 {
     size_t size;
-    int rv;
     void *flat_buffer;
     // Send the return value
-    flatcc_builder_t *B = &builder;
+    flatcc_builder_t *B = Ctx->Builder;
+
+    PROXY_TraceCallDone(&Ctx->Trace);
 
     nsr(Empty_ref_t) empty = nsr(Empty_create(B));
     nsr(PointerReturn_union_ref_t) output = nsr(PointerReturn_as_Empty(empty));
@@ -272,13 +385,7 @@ void return_regular_cFETime(CFE_TIME_SysTime_t time)
     nsr(ReturnData_create_as_root(B, retval, output));
 
     flat_buffer = flatcc_builder_finalize_aligned_buffer(B, &size);
-    rv = nng_send(sock, flat_buffer, size, 0);
-    if (rv != 0)
-    {
-        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - NNG error: %s", __func__, nng_strerror(rv));
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
-    }
+    send_call_reply(Ctx, __func__, flat_buffer, size);
 
     flatcc_builder_aligned_free(flat_buffer);
     /*
@@ -288,295 +395,630 @@ void return_regular_cFETime(CFE_TIME_SysTime_t time)
     flatcc_builder_reset(B);
 }
 
-void incoming_message(void)
+// Receive and service at most one remote call from the actual app.
+// nng_flags is passed on to nng_recv: 0 waits up to ACTUAL_NNG_TIMEOUT, NNG_FLAG_NONBLOCK does not wait.
+// Returns true if a message was serviced.
+bool incoming_message(int nng_flags)
 {
-    int rv, index;
     char *buffer = NULL;
     size_t sz;
-    int32 call_return;
 
-    rv = nng_recv(sock, &buffer, &sz, NNG_FLAG_ALLOC);
-    if (rv == 0)
+    if (receive_message(nng_flags, &buffer, &sz) == 0)
     {
-        PROXY_HkTelemetryPkt.actual_func_calls++;
-        PROXY_HkTelemetryPkt.actual_run_state = ACTUAL_STATE_RUNNING;
+        process_message(buffer, sz);
+        return true;
+    }
 
-        ns(RemoteCall_table_t) remoteCall = ns(RemoteCall_as_root(buffer));
-        switch(ns(RemoteCall_input_type(remoteCall)))
-        {
-            // ES Functions
-            case ns(Function_RunLoop):
-            {
-                if (VERBOSE) {printf("RunLoop called.\n");}
+    return false;
+}
 
-                // I don't know why the RunLoop status is call ExitStatus, and I don't know
-                // why it gets passed as a pointer. It's not used like a pointer...
-                ns(RunLoop_table_t) runLoop = (ns(RunLoop_table_t)) ns(RemoteCall_input(remoteCall));
-                uint32_t ExitStatus = ns(RunLoop_ExitStatus(runLoop));
-                call_return = CFE_ES_RunLoop(&ExitStatus);
+// Receive one message from the actual app, the nng_recv return code is returned.
+// On success the buffer must be passed to process_message.
+int receive_message(int nng_flags, char **buffer, size_t *sz)
+{
+    int rv;
 
-                return_regular_int32(call_return);
-                break;
-            }
-            case ns(Function_PerfLogAdd):
-            {
-                if (VERBOSE) {printf("PerfLogAdd called.\n");}
+    rv = nng_recv(sock, buffer, sz, NNG_FLAG_ALLOC | nng_flags);
+    if (rv == 0 || rv == NNG_ETIMEDOUT || rv == NNG_EAGAIN)
+    {
+        // Nothing from Actual is not an error. The longer timeout is handled by PROXY_CheckLiveness
+    }
+    else
+    {
+        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
+        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                  "Proxy %s - NNG error: %s", __func__, nng_strerror(rv));
+    }
 
-                ns(PerfLogAdd_table_t) perfLogAdd = (ns(PerfLogAdd_table_t)) ns(RemoteCall_input(remoteCall));
-                uint32_t Marker = ns(PerfLogAdd_Marker(perfLogAdd));
-                uint32_t EntryExit = ns(PerfLogAdd_EntryExit(perfLogAdd));
-                CFE_ES_PerfLogAdd(Marker, EntryExit);
+    return rv;
+}
 
-                // Void return
-                break;
-            }
-            case ns(Function_RegisterApp):
-            {
-                if (VERBOSE) {printf("RegisterApp called.\n");}
+// Service one message (a RemoteCall or a control frame) from the actual app and free its buffer
+void process_message(char *buffer, size_t sz)
+{
+    process_message_from(sock, buffer, sz);
+}
 
-                // This shouldn't happen: the actual app's es wrapper noops. The proxy registers.
-                printf("Error: Actual app attempted to registers with ES\n");
+// Service one message received on Sock, the reply goes back on it
+void process_message_from(nng_socket Sock, char *buffer, size_t sz)
+{
+    // Markers the app hit before sending this message come first
+    PROXY_PerfDrain();
 
-                return_regular_int32(0);
-                break;
-            }
-            case ns(Function_ExitApp):
-            {
-                if (VERBOSE) {printf("ExitApp called.\n");}
+    PROXY_HkTelemetryPkt.actual_run_state = ACTUAL_STATE_RUNNING;
+    PROXY_LastMsgNs = PROXY_MonotonicNs();
+
+    PROXY_StatsCount(&PROXY_Stats->Messages);
+    __atomic_store_n(&PROXY_Stats->LastMsgNs, PROXY_LastMsgNs, __ATOMIC_RELAXED);
 
-                ns(ExitApp_table_t) exitApp = (ns(ExitApp_table_t)) ns(RemoteCall_input(remoteCall));
+    PROXY_RecordFrame(PROXY_RECORD_REQUEST, buffer, sz);
 
-                uint32 ExitStatus = ns(ExitApp_ExitStatus(exitApp));
+    PROXY_CtrlPoll();
 
-                // TODO: Err... no. Not how this should go down...
-                // The actual app should exit... and clean up its resources (done in proxy client es wrap)
+    if (PROXY_PoolDispatch(buffer, sz, Sock, PROXY_LastMsgNs))
+    {
+        // The worker frees the buffer
+        return;
+    }
 
-                // Less sure about what happens to PROXY
-                // send a EVS message? Then exit itself? Or stay alive? Send one last HK?
-                PROXY_HkTelemetryPkt.actual_run_state = ACTUAL_STATE_EXITED;
-                cleanup_and_exit(ExitStatus);
+    PROXY_MainCtx.Sock   = Sock;
+    PROXY_MainCtx.RecvNs = PROXY_LastMsgNs;
+    if (PROXY_IsCtrlFrame(buffer, sz))
+    {
+        PROXY_ProcessCtrlFrame(buffer, sz);
+    }
+    else
+    {
+        process_remote_call(&PROXY_MainCtx, buffer, sz);
+    }
 
-                // Void return
-                break;
-            }
+    nng_free(buffer, sz);
+}
 
-            // EVS Functions
-            case ns(Function_SendEvent):
-            {
-                if (VERBOSE) {printf("SendEvent called!!!\n");}
+// The Function_* types implemented by process_remote_call, advertised to the client.
+// Keep this in step with the switch below.
+static const uint8 PROXY_SupportedFunctions[] =
+    {
+        ns(Function_RunLoop),
+        ns(Function_PerfLogAdd),
+        ns(Function_RegisterApp),
+        ns(Function_ExitApp),
+        ns(Function_SendEvent),
+        ns(Function_SendEventWithAppID),
+        ns(Function_SendTimedEvent),
+        ns(Function_Register),
+        ns(Function_ResetFilter),
+        ns(Function_ResetAllFilters),
+        ns(Function_TIME_GetTime),
+        ns(Function_TIME_GetTAI),
+        ns(Function_TIME_GetUTC),
+        ns(Function_TIME_MET2SCTime),
+        ns(Function_TIME_GetSTCF),
+        ns(Function_TIME_GetMET),
+        ns(Function_TIME_GetMETseconds),
+        ns(Function_TIME_GetMETsubsecs),
+        ns(Function_TIME_GetLeapSeconds),
+        ns(Function_TIME_GetClockState),
+        ns(Function_TIME_GetClockInfo),
+    };
 
-                ns(SendEvent_table_t) sendEvent = (ns(SendEvent_table_t)) ns(RemoteCall_input(remoteCall));
-                uint16_t EventID = ns(SendEvent_EventID(sendEvent));
-                uint16_t EventType = ns(SendEvent_EventType(sendEvent));
-                const char *spec_string = ns(SendEvent_Spec(sendEvent));
+// Fills a bitmap with bit n set when Function_* type n is implemented
+void PROXY_GetSupportedFunctions(uint32 *Bitmap, size_t Words)
+{
+    size_t index;
 
-                call_return = CFE_EVS_SendEvent(EventID, EventType, spec_string);
-                return_regular_int32(call_return);
-                break;
-            }
-            case ns(Function_SendEventWithAppID):
-            {
-                if (VERBOSE) {printf("SendEventWithAppID called !!!\n");}
-
-                ns(SendEventWithAppID_table_t) sendEvent = (ns(SendEventWithAppID_table_t)) ns(RemoteCall_input(remoteCall));
-                uint16_t EventID = ns(SendEventWithAppID_EventID(sendEvent));
-                uint16_t EventType = ns(SendEventWithAppID_EventType(sendEvent));
-                uint32_t AppID = ns(SendEventWithAppID_AppID(sendEvent));
-                CFE_ES_AppId_t AppId_struct;
-                AppId_struct = CFE_ResourceId_FromInteger(AppID);
-                const char *spec_string = ns(SendEventWithAppID_Spec(sendEvent));
-
-                call_return = CFE_EVS_SendEventWithAppID(EventID, EventType, AppId_struct, spec_string);
-                return_regular_int32(call_return);
-                break;
-            }
-            case ns(Function_SendTimedEvent):
-            {
-                if (VERBOSE) {printf("SendTimedEvent called\n");}
+    memset(Bitmap, 0, Words * sizeof(uint32));
+    for (index = 0; index < sizeof(PROXY_SupportedFunctions); index++)
+    {
+        if (PROXY_SupportedFunctions[index] / 32 < Words)
+        {
+            Bitmap[PROXY_SupportedFunctions[index] / 32] |= 1U << (PROXY_SupportedFunctions[index] % 32);
+        }
+    }
+}
 
-                ns(SendTimedEvent_table_t) sendTimedEvent = (ns(SendTimedEvent_table_t)) ns(RemoteCall_input(remoteCall));
-                cFETime_table_t time = ns(SendTimedEvent_Time(sendTimedEvent));
-                CFE_TIME_SysTime_t cfe_time;
-                cfe_time.Seconds = cFETime_Seconds(time);
-                cfe_time.Subseconds = cFETime_Subseconds(time);
-                uint16_t EventID = ns(SendTimedEvent_EventID(sendTimedEvent));
-                uint16_t EventType = ns(SendTimedEvent_EventType(sendTimedEvent));
+// False for the Function_* types that return void, the client does not wait for a reply
+bool PROXY_FunctionHasReply(uint8 Function)
+{
+    return Function != ns(Function_PerfLogAdd) && Function != ns(Function_ExitApp);
+}
 
-                const char *spec_string = ns(SendTimedEvent_Spec(sendTimedEvent));
+// Replies the proxy sends for a message of the actual app, kept in the capture for replay
+uint16 PROXY_ExpectedReplies(const void *Buffer, size_t Size)
+{
+    const PROXY_CtrlHdr_t        *Hdr = Buffer;
+    const PROXY_CtrlBatchEntry_t *Entry;
+    size_t offset = sizeof(PROXY_CtrlBatch_t);
+    uint16 replies = 0;
+    uint16 index;
 
-                call_return = CFE_EVS_SendTimedEvent(cfe_time, EventID, EventType, spec_string);
-                return_regular_int32(call_return);
-                break;
-            }
-            case ns(Function_Register):
-            {
-                if (VERBOSE) {printf("EVS Register called\n");}
+    if (!PROXY_IsCtrlFrame(Buffer, Size))
+    {
+        return PROXY_FunctionHasReply(ns(RemoteCall_input_type(ns(RemoteCall_as_root(Buffer))))) ? 1 : 0;
+    }
 
-                ns(Register_table_t) registerEvents = (ns(Register_table_t)) ns(RemoteCall_input(remoteCall));
-                uint16 NumFilteredEvents = ns(Register_NumFilteredEvents(registerEvents));
-                uint16 FilterScheme = ns(Register_FilterScheme(registerEvents));
+    if (Hdr->Type == PROXY_CTRL_READY)
+    {
+        return 0;
+    }
+    if (Hdr->Type != PROXY_CTRL_BATCH || Size > PROXY_CTRL_MAX_LENGTH)
+    {
+        // Every other frame has a reply, PROXY_CTRL_ERROR if nothing else
+        return 1;
+    }
+    if (Size < sizeof(PROXY_CtrlBatch_t) || Hdr->Length < sizeof(PROXY_CtrlBatch_t) ||
+        PROXY_CtrlBatchCheck(Buffer, Size) < ((const PROXY_CtrlBatch_t *) Buffer)->Count)
+    {
+        // A malformed batch is answered with one PROXY_CTRL_ERROR
+        return 1;
+    }
 
-                ns(Filter_vec_t) filters = ns(Register_Filters(registerEvents));
-                size_t filter_len = ns(Filter_vec_len(filters));
+    // Each call of a batch is answered on its own
+    for (index = 0; index < ((const PROXY_CtrlBatch_t *) Buffer)->Count; index++)
+    {
+        Entry = PROXY_CtrlBatchEntry(Buffer, Size, &offset);
+        if (PROXY_FunctionHasReply(ns(RemoteCall_input_type(ns(RemoteCall_as_root((const char *) (Entry + 1)))))))
+        {
+            replies++;
+        }
+    }
 
-                CFE_EVS_BinFilter_t *new_filters;
-                new_filters = malloc(filter_len * sizeof(CFE_EVS_BinFilter_t));
+    return replies;
+}
 
-                for (index = 0; index < filter_len; index++)
-                {
-                    new_filters[index].EventID = ns(Filter_EventID(ns(Filter_vec_at(filters, index))));
-                    new_filters[index].Mask = ns(Filter_Mask(ns(Filter_vec_at(filters, index))));
-                }
+// Answers a RemoteCall that can not be serviced with CFE_STATUS_NOT_IMPLEMENTED, if the
+// client waits for a reply. The buffer is not freed.
+void reject_remote_call(PROXY_CallCtx_t *Ctx, const char *buffer, size_t sz)
+{
+    ns(RemoteCall_table_t) remoteCall = ns(RemoteCall_as_root(buffer));
 
-                call_return = CFE_EVS_Register(new_filters, NumFilteredEvents, FilterScheme);
+    if (PROXY_FunctionHasReply(ns(RemoteCall_input_type(remoteCall))))
+    {
+        return_regular_int32(Ctx, CFE_STATUS_NOT_IMPLEMENTED);
+    }
+}
 
-                return_regular_int32(call_return);
+// Decode and run one RemoteCall, sending its reply. The buffer is not freed.
+// Runs on the proxy task or on a worker, see proxy_pool.c for the calls that stay on the proxy task.
+void process_remote_call(PROXY_CallCtx_t *Ctx, const char *buffer, size_t sz)
+{
+    int index;
+    int32 call_return;
 
-                free(new_filters);
+    PROXY_TraceBegin(&Ctx->Trace, Ctx->RecvNs);
 
-                break;
+    ns(RemoteCall_table_t) remoteCall = ns(RemoteCall_as_root(buffer));
+    PROXY_TraceDispatch(&Ctx->Trace, ns(RemoteCall_input_type(remoteCall)));
+    switch(ns(RemoteCall_input_type(remoteCall)))
+    {
+        // ES Functions
+        case ns(Function_RunLoop):
+        {
+            // I don't know why the RunLoop status is call ExitStatus, and I don't know
+            // why it gets passed as a pointer. It's not used like a pointer...
+            ns(RunLoop_table_t) runLoop = (ns(RunLoop_table_t)) ns(RemoteCall_input(remoteCall));
+            uint32_t ExitStatus = ns(RunLoop_ExitStatus(runLoop));
+            if (PROXY_HandoverStandby(Ctx->Sock))
+            {
+                // Only the old app gets here, the replacement has taken over. This tells it to exit.
+                call_return = false;
             }
-            // TODO: remove EVS_Unregister
-            case ns(Function_ResetFilter):
+            else
             {
-                if (VERBOSE) {printf("Reset Filter called\n");}
+                call_return = CFE_ES_RunLoop(&ExitStatus);
+            }
+            if (PROXY_Startup.FirstRunLoopNs == 0)
+            {
+                PROXY_Startup.FirstRunLoopNs = PROXY_MonotonicNs();
+            }
 
-                ns(ResetFilter_table_t) resetFilter = (ns(ResetFilter_table_t)) ns(RemoteCall_input(remoteCall));
-                uint16 EventID = ns(ResetFilter_EventID(resetFilter));
+            return_regular_int32(Ctx, call_return);
+            break;
+        }
+        case ns(Function_PerfLogAdd):
+        {
+            ns(PerfLogAdd_table_t) perfLogAdd = (ns(PerfLogAdd_table_t)) ns(RemoteCall_input(remoteCall));
+            uint32_t Marker = ns(PerfLogAdd_Marker(perfLogAdd));
+            uint32_t EntryExit = ns(PerfLogAdd_EntryExit(perfLogAdd));
+            CFE_ES_PerfLogAdd(Marker, EntryExit);
 
-                call_return = CFE_EVS_ResetFilter(EventID);
+            // Void return
+            break;
+        }
+        case ns(Function_RegisterApp):
+        {
+            // This shouldn't happen: the actual app's es wrapper noops. The proxy registers.
+            printf("Error: Actual app attempted to registers with ES\n");
 
-                return_regular_int32(call_return);
+            return_regular_int32(Ctx, 0);
+            break;
+        }
+        case ns(Function_ExitApp):
+        {
+            ns(ExitApp_table_t) exitApp = (ns(ExitApp_table_t)) ns(RemoteCall_input(remoteCall));
 
+            uint32 ExitStatus = ns(ExitApp_ExitStatus(exitApp));
+
+            if (PROXY_HandoverStandby(Ctx->Sock))
+            {
+                // The old app of a handover is done (or the replacement gave up), the proxy carries on
                 break;
             }
-            case ns(Function_ResetAllFilters):
-            {
-                if (VERBOSE) {printf("ResetAllFilters called\n");}
 
-                call_return = CFE_EVS_ResetAllFilters();
+            // TODO: Err... no. Not how this should go down...
+            // The actual app should exit... and clean up its resources (done in proxy client es wrap)
 
-                return_regular_int32(call_return);
+            // Less sure about what happens to PROXY
+            // send a EVS message? Then exit itself? Or stay alive? Send one last HK?
+            PROXY_HkTelemetryPkt.actual_run_state = ACTUAL_STATE_EXITED;
+            cleanup_and_exit(ExitStatus);
 
-                break;
-            }
+            // Void return
+            break;
+        }
 
-            // TIME Functions
-            case ns(Function_TIME_GetTime):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetTime called\n");}
+        // EVS Functions
+        case ns(Function_SendEvent):
+        {
+            ns(SendEvent_table_t) sendEvent = (ns(SendEvent_table_t)) ns(RemoteCall_input(remoteCall));
+            uint16_t EventID = ns(SendEvent_EventID(sendEvent));
+            uint16_t EventType = ns(SendEvent_EventType(sendEvent));
+            const char *spec_string = ns(SendEvent_Spec(sendEvent));
 
-                return_regular_cFETime(CFE_TIME_GetTime());
+            call_return = CFE_EVS_SendEvent(EventID, EventType, spec_string);
+            return_regular_int32(Ctx, call_return);
+            break;
+        }
+        case ns(Function_SendEventWithAppID):
+        {
+            ns(SendEventWithAppID_table_t) sendEvent = (ns(SendEventWithAppID_table_t)) ns(RemoteCall_input(remoteCall));
+            uint16_t EventID = ns(SendEventWithAppID_EventID(sendEvent));
+            uint16_t EventType = ns(SendEventWithAppID_EventType(sendEvent));
+            uint32_t AppID = ns(SendEventWithAppID_AppID(sendEvent));
+            CFE_ES_AppId_t AppId_struct;
+            AppId_struct = CFE_ResourceId_FromInteger(AppID);
+            const char *spec_string = ns(SendEventWithAppID_Spec(sendEvent));
+
+            call_return = CFE_EVS_SendEventWithAppID(EventID, EventType, AppId_struct, spec_string);
+            return_regular_int32(Ctx, call_return);
+            break;
+        }
+        case ns(Function_SendTimedEvent):
+        {
+            ns(SendTimedEvent_table_t) sendTimedEvent = (ns(SendTimedEvent_table_t)) ns(RemoteCall_input(remoteCall));
+            cFETime_table_t time = ns(SendTimedEvent_Time(sendTimedEvent));
+            CFE_TIME_SysTime_t cfe_time;
+            cfe_time.Seconds = cFETime_Seconds(time);
+            cfe_time.Subseconds = cFETime_Subseconds(time);
+            uint16_t EventID = ns(SendTimedEvent_EventID(sendTimedEvent));
+            uint16_t EventType = ns(SendTimedEvent_EventType(sendTimedEvent));
+
+            const char *spec_string = ns(SendTimedEvent_Spec(sendTimedEvent));
+
+            call_return = CFE_EVS_SendTimedEvent(cfe_time, EventID, EventType, spec_string);
+            return_regular_int32(Ctx, call_return);
+            break;
+        }
+        case ns(Function_Register):
+        {
+            ns(Register_table_t) registerEvents = (ns(Register_table_t)) ns(RemoteCall_input(remoteCall));
+            uint16 NumFilteredEvents = ns(Register_NumFilteredEvents(registerEvents));
+            uint16 FilterScheme = ns(Register_FilterScheme(registerEvents));
 
-                break;
-            }
-            case ns(Function_TIME_GetTAI):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetTAI called\n");}
+            ns(Filter_vec_t) filters = ns(Register_Filters(registerEvents));
+            size_t filter_len = ns(Filter_vec_len(filters));
 
-                return_regular_cFETime(CFE_TIME_GetTAI());
+            CFE_EVS_BinFilter_t *new_filters;
+            new_filters = malloc(filter_len * sizeof(CFE_EVS_BinFilter_t));
 
-                break;
-            }
-            case ns(Function_TIME_GetUTC):
+            for (index = 0; index < filter_len; index++)
             {
-                if (VERBOSE) {printf("Function_TIME_GetUTC called\n");}
+                new_filters[index].EventID = ns(Filter_EventID(ns(Filter_vec_at(filters, index))));
+                new_filters[index].Mask = ns(Filter_Mask(ns(Filter_vec_at(filters, index))));
+            }
 
-                return_regular_cFETime(CFE_TIME_GetUTC());
+            if (NumFilteredEvents > filter_len)
+            {
+                NumFilteredEvents = filter_len;
+            }
 
-                break;
+            if (PROXY_HandoverKeepRegistration())
+            {
+                // Registered by the app this one replaced, the filters and their counts carry over
+                call_return = CFE_SUCCESS;
             }
-            case ns(Function_TIME_MET2SCTime):
+            else if (PROXY_EvsLocal())
             {
-                if (VERBOSE) {printf("Function_TIME_MET2SCTime called\n");}
+                call_return = PROXY_EvsRegister(new_filters, NumFilteredEvents, FilterScheme);
+            }
+            else
+            {
+                call_return = CFE_EVS_Register(new_filters, NumFilteredEvents, FilterScheme);
+            }
+            PROXY_HkTelemetryPkt.actual_registered = true;
 
-                ns(TIME_MET2SCTime_table_t) function_table = (ns(TIME_MET2SCTime_table_t)) ns(RemoteCall_input(remoteCall));
-                cFETime_table_t time = ns(TIME_MET2SCTime_METTime(function_table));
-                CFE_TIME_SysTime_t cfe_time;
-                cfe_time.Seconds = cFETime_Seconds(time);
-                cfe_time.Subseconds = cFETime_Subseconds(time);
+            return_regular_int32(Ctx, call_return);
 
-                return_regular_cFETime(CFE_TIME_MET2SCTime(cfe_time));
+            free(new_filters);
 
-                break;
-            }
-            case ns(Function_TIME_GetSTCF):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetSTCF called\n");}
+            break;
+        }
+        // TODO: remove EVS_Unregister
+        case ns(Function_ResetFilter):
+        {
+            ns(ResetFilter_table_t) resetFilter = (ns(ResetFilter_table_t)) ns(RemoteCall_input(remoteCall));
+            uint16 EventID = ns(ResetFilter_EventID(resetFilter));
 
-                return_regular_cFETime(CFE_TIME_GetSTCF());
+            call_return = PROXY_EvsLocal() ? PROXY_EvsResetFilter(EventID) : CFE_EVS_ResetFilter(EventID);
 
-                break;
-            }
-            case ns(Function_TIME_GetMET):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetMET called\n");}
+            return_regular_int32(Ctx, call_return);
 
-                return_regular_cFETime(CFE_TIME_GetMET());
+            break;
+        }
+        case ns(Function_ResetAllFilters):
+        {
+            call_return = PROXY_EvsLocal() ? PROXY_EvsResetAllFilters() : CFE_EVS_ResetAllFilters();
 
-                break;
-            }
-            case ns(Function_TIME_GetMETseconds):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetMETseconds called\n");}
+            return_regular_int32(Ctx, call_return);
 
-                return_regular_uint32(CFE_TIME_GetMETseconds());
+            break;
+        }
 
-                break;
-            }
-            case ns(Function_TIME_GetMETsubsecs):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetMETsubsecs called\n");}
+        // TIME Functions
+        case ns(Function_TIME_GetTime):
+        {
+            return_regular_cFETime(Ctx, CFE_TIME_GetTime());
 
-                return_regular_uint32(CFE_TIME_GetMETsubsecs());
+            break;
+        }
+        case ns(Function_TIME_GetTAI):
+        {
+            return_regular_cFETime(Ctx, CFE_TIME_GetTAI());
 
-                break;
-            }
-            case ns(Function_TIME_GetLeapSeconds):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetLeapSeconds called\n");}
+            break;
+        }
+        case ns(Function_TIME_GetUTC):
+        {
+            return_regular_cFETime(Ctx, CFE_TIME_GetUTC());
 
-                return_regular_int16(CFE_TIME_GetLeapSeconds());
+            break;
+        }
+        case ns(Function_TIME_MET2SCTime):
+        {
+            ns(TIME_MET2SCTime_table_t) function_table = (ns(TIME_MET2SCTime_table_t)) ns(RemoteCall_input(remoteCall));
+            cFETime_table_t time = ns(TIME_MET2SCTime_METTime(function_table));
+            CFE_TIME_SysTime_t cfe_time;
+            cfe_time.Seconds = cFETime_Seconds(time);
+            cfe_time.Subseconds = cFETime_Subseconds(time);
 
-                break;
-            }
-            case ns(Function_TIME_GetClockState):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetClockState called\n");}
+            return_regular_cFETime(Ctx, CFE_TIME_MET2SCTime(cfe_time));
 
-                return_regular_int16(CFE_TIME_GetClockState());
+            break;
+        }
+        case ns(Function_TIME_GetSTCF):
+        {
+            return_regular_cFETime(Ctx, CFE_TIME_GetSTCF());
 
-                break;
-            }
-            case ns(Function_TIME_GetClockInfo):
-            {
-                if (VERBOSE) {printf("Function_TIME_GetClockInfo called\n");}
+            break;
+        }
+        case ns(Function_TIME_GetMET):
+        {
+            return_regular_cFETime(Ctx, CFE_TIME_GetMET());
 
-                return_regular_uint16(CFE_TIME_GetClockInfo());
+            break;
+        }
+        case ns(Function_TIME_GetMETseconds):
+        {
+            return_regular_uint32(Ctx, CFE_TIME_GetMETseconds());
 
-                break;
-            }
+            break;
+        }
+        case ns(Function_TIME_GetMETsubsecs):
+        {
+            return_regular_uint32(Ctx, CFE_TIME_GetMETsubsecs());
 
-            default:
-                CFE_EVS_SendEventWithAppID(PROXY_UNIMPLEMENTED_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - unknown/unimplemented function: %d", __func__, ns(RemoteCall_input_type(remoteCall)));
+            break;
         }
+        case ns(Function_TIME_GetLeapSeconds):
+        {
+            return_regular_int16(Ctx, CFE_TIME_GetLeapSeconds());
+
+            break;
+        }
+        case ns(Function_TIME_GetClockState):
+        {
+            return_regular_int16(Ctx, CFE_TIME_GetClockState());
+
+            break;
+        }
+        case ns(Function_TIME_GetClockInfo):
+        {
+            return_regular_uint16(Ctx, CFE_TIME_GetClockInfo());
 
-        nng_free(buffer, sz);
+            break;
+        }
+
+        default:
+            CFE_EVS_SendEventWithAppID(PROXY_UNIMPLEMENTED_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                              "Proxy %s - unknown/unimplemented function: %d", __func__, ns(RemoteCall_input_type(remoteCall)));
+
+            // Reply anyway so the caller fails fast instead of waiting forever
+            return_regular_int32(Ctx, CFE_STATUS_NOT_IMPLEMENTED);
     }
-    else if (rv == NNG_ETIMEDOUT)
+
+    PROXY_TraceEnd(&Ctx->Trace);
+    PROXY_StatsCallDone(Ctx->RecvNs);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_RunSlice                                                     */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         One bounded slice of work, run for each PROXY_WAKEUP_MID. Drains   */
+/*         remote calls up to the message and time budgets, checks the        */
+/*         actual app liveness and optionally sends housekeeping.            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_RunSlice(void)
+{
+    uint64 start_ns = PROXY_MonotonicNs();
+    uint64 elapsed_us = 0;
+    uint16 msgs = 0;
+    bool   overrun = false;
+
+    while (msgs < PROXY_SLICE_MSG_BUDGET)
     {
-        // TODO: longer timeout check and set HK as needed
-        // printf("Timed out waiting for a message from Actual\n");
+        if (!incoming_message(NNG_FLAG_NONBLOCK))
+        {
+            break;
+        }
+        msgs++;
+
+        elapsed_us = (PROXY_MonotonicNs() - start_ns) / 1000;
+        if (elapsed_us >= PROXY_SLICE_TIME_BUDGET_US)
+        {
+            overrun = true;
+            break;
+        }
     }
-    else
+    if (msgs >= PROXY_SLICE_MSG_BUDGET)
     {
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
-        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - NNG error: %s", __func__, nng_strerror(rv));
+        // There may be more waiting, it will be picked up on the next wakeup
+        overrun = true;
+    }
+
+    PROXY_CheckLiveness();
+
+    elapsed_us = (PROXY_MonotonicNs() - start_ns) / 1000;
+
+    PROXY_HkTelemetryPkt.slice_count++;
+    PROXY_HkTelemetryPkt.slice_last_msgs = msgs;
+    PROXY_HkTelemetryPkt.slice_last_us   = elapsed_us;
+    if (msgs > PROXY_HkTelemetryPkt.slice_max_msgs)
+    {
+        PROXY_HkTelemetryPkt.slice_max_msgs = msgs;
+    }
+    if (elapsed_us > PROXY_HkTelemetryPkt.slice_max_us)
+    {
+        PROXY_HkTelemetryPkt.slice_max_us = elapsed_us;
+    }
+    if (overrun)
+    {
+        PROXY_HkTelemetryPkt.slice_overruns++;
+    }
+
+    if (PROXY_SLICE_HK_DIVISOR && (PROXY_HkTelemetryPkt.slice_count % PROXY_SLICE_HK_DIVISOR) == 0)
+    {
+        PROXY_ReportHousekeeping();
+    }
+} /* End of PROXY_RunSlice() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_CheckLiveness                                                */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Updates the age of the last message from the actual app and marks  */
+/*         it as timed out when it has been quiet for too long.               */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_CheckLiveness(void)
+{
+    uint64 age_ms;
+
+    if (PROXY_LastMsgNs == 0)
+    {
+        // Nothing received yet
+        return;
+    }
+
+    age_ms = (PROXY_MonotonicNs() - PROXY_LastMsgNs) / 1000000;
+    PROXY_HkTelemetryPkt.actual_ms_last_msg = age_ms;
+
+    if (age_ms > PROXY_LIVENESS_TIMEOUT_MS &&
+        PROXY_HkTelemetryPkt.actual_run_state == ACTUAL_STATE_RUNNING)
+    {
+        PROXY_HkTelemetryPkt.actual_run_state = ACTUAL_STATE_TIMED_OUT;
     }
+} /* End of PROXY_CheckLiveness() */
+
+// Time of a startup phase relative to PROXY_Init, 0 if it has not happened yet
+uint32 PROXY_StartupUs(uint64 PhaseNs)
+{
+    if (PhaseNs == 0)
+    {
+        return 0;
+    }
+    return (PhaseNs - PROXY_Startup.InitNs) / 1000;
+}
+
+uint64 PROXY_MonotonicNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64) now.tv_sec * 1000000000) + now.tv_nsec;
 }
 
+// nng pipe notification, runs on an nng thread
+static void PROXY_PipeEvent(nng_pipe pipe, nng_pipe_ev event, void *arg)
+{
+    uint64 expected = 0;
+
+    if (event == NNG_PIPE_EV_ADD_POST)
+    {
+        __atomic_compare_exchange_n(&PROXY_Startup.ConnectNs, &expected, PROXY_MonotonicNs(),
+                                    false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&PROXY_Startup.Connects, 1, __ATOMIC_RELAXED);
+    }
+    else if (event == NNG_PIPE_EV_REM_POST && nng_socket_id(nng_pipe_socket(pipe)) == nng_socket_id(sock))
+    {
+        // The actual app went away, whatever connects next negotiates again
+        PROXY_CtrlDisconnected();
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_OpenSocket                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Opens a pair socket listening on Address. Returns the first nng    */
+/*         error (also kept in housekeeping) and the call that failed, the    */
+/*         caller sends the event.                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+int PROXY_OpenSocket(nng_socket *Socket, const char *Address, const char **FailedCall)
+{
+    int rv;
+
+    if ((rv = nng_pair0_open(Socket)) != 0)
+    {
+        *FailedCall = "nng_pair0_open";
+    }
+    else if ((rv = nng_pipe_notify(*Socket, NNG_PIPE_EV_ADD_POST, PROXY_PipeEvent, NULL)) != 0 ||
+             (rv = nng_pipe_notify(*Socket, NNG_PIPE_EV_REM_POST, PROXY_PipeEvent, NULL)) != 0)
+    {
+        *FailedCall = "nng_pipe_notify";
+    }
+    // Listen doesn't timeout waiting for a connection.
+    else if ((rv = nng_listen(*Socket, Address, NULL, 0)) != 0)
+    {
+        *FailedCall = "nng_listen";
+    }
+    else if ((rv = nng_setopt_ms(*Socket, NNG_OPT_RECVTIMEO, ACTUAL_NNG_TIMEOUT)) != 0)
+    {
+        *FailedCall = "nng_setopt_ms";
+    }
+    // Also what keeps PROXY_CTRL_MAGIC from ever being a valid flatbuffer root offset
+    else if ((rv = nng_setopt_size(*Socket, NNG_OPT_RECVMAXSZ, PROXY_MAX_MESSAGE_SIZE)) != 0)
+    {
+        *FailedCall = "nng_setopt_size";
+    }
+
+    if (rv != 0)
+    {
+        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
+    }
+
+    return rv;
+} /* End of PROXY_OpenSocket() */
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *  */
 /*                                                                            */
 /* PROXY_Init() --  initialization                                       */
@@ -584,6 +1026,8 @@ void incoming_message(void)
 /* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
 void PROXY_Init(void)
 {
+    PROXY_Startup.InitNs = PROXY_MonotonicNs();
+
     /*
     ** Register the events -
     ** The actual app will register with EVS. Proxy uses PEVS to send events.
@@ -596,50 +1040,34 @@ void PROXY_Init(void)
     CFE_SB_CreatePipe(&PROXY_CommandPipe, PROXY_PIPE_DEPTH, "PROXY_CMD_PIPE");
     CFE_SB_Subscribe(PROXY_CMD_MID, PROXY_CommandPipe);
     CFE_SB_Subscribe(PROXY_SEND_HK_MID, PROXY_CommandPipe);
+    if (PROXY_SCHEDULED_MODE)
+    {
+        CFE_SB_Subscribe(PROXY_WAKEUP_MID, PROXY_CommandPipe);
+    }
 
     CFE_MSG_Init(&PROXY_HkTelemetryPkt.TlmHeader.Msg, PROXY_HK_TLM_MID, PROXY_HK_TLM_LNGTH);
 
     PROXY_HkTelemetryPkt.actual_run_state = ACTUAL_STATE_UNKOWN;
 
-    // Give PEVS a change to start up
-    // This function is typically called as the last line of the of the init function,
-    // but we want to be able to send event messages (via PEVS) so need it earlier
-    CFE_ES_WaitForStartupSync(2000);
+    PROXY_WaitInit();
 
-    PROXY_HkTelemetryPkt.proxy_pevs_access = CFE_ES_GetAppIDByName(&proxy_evs_id, "PEVS");
-    // printf("PROXY Attempts to find PEVS: 0x%04X - %d\n", PROXY_HkTelemetryPkt.proxy_pevs_access, proxy_evs_id);
-    if (PROXY_HkTelemetryPkt.proxy_pevs_access != CFE_SUCCESS)
+    // Flat Buff init
+    flatcc_builder_init(&builder);
+
+    // Listen before launching the actual app, so its first dial finds the proxy.
+    // PEVS may not be up yet, so errors are only reported after the startup sync.
+    const char *nng_call;
+    int rv = PROXY_OpenSocket(&sock, IPC_PIPE_ADDRESS, &nng_call);
+    if (rv == 0 && (rv = PROXY_OutInit()) != 0)
     {
-        // Can't exactly send a EVS message if this doesn't work. Not sure what else to do.
-        printf("PROXY failed to find PEVS\n");
+        // Replies are then sent blocking
+        nng_call = "PROXY_OutInit";
     }
-
-    PROXY_ResetCounters();
+    PROXY_Startup.ListenNs = PROXY_MonotonicNs();
 
     // Fork / Exec the actual process
-    // TODO: Event for fork / exec issues
-
-    childPID = fork();
-    if (childPID >= 0)
-    { // Forked
-        if (childPID == 0)
-        { // Child process
-            // printf("The child has forked %d\n", getpid());
-            if (-1 == execlp(EXEC_INSTRUCTION, EXEC_ARGUMENTS, NULL))
-            {
-                // I don't know how to indicate that this has happened.
-                // A child process can not write to the parent's memory (so HK telemetry won't work)
-                // It can read the parent's data, such as proxy_evs_access, but can't call the the correct CFE_EVS_SendEventWithAppID
-                perror("Exec error!!!\n");
-                exit(0); // The child must exit
-            }
-        }
-    }
-    else
-    {
-        PROXY_HkTelemetryPkt.proxy_fork_error = errno;
-        printf("Fork error\n");
-    }
+    childPID = PROXY_LaunchChild(&PROXY_LaunchAttr);
+    PROXY_Startup.LaunchNs = PROXY_MonotonicNs();
 
     // This code block is for debugging the child process if it fails after the exec succeeds.
     // It waits on the process and prints the reason is died.
@@ -662,34 +1090,38 @@ void PROXY_Init(void)
         printf("continued\n");
     } */
 
-    // Flat Buff init
-    flatcc_builder_init(&builder);
-
-    // Wait for connection from actual application
-    int rv;
+    // Give PEVS a change to start up
+    // This function is typically called as the last line of the of the init function,
+    // but we want to be able to send event messages (via PEVS) so need it earlier.
+    // The actual app boots while we wait.
+    CFE_ES_WaitForStartupSync(2000);
+    PROXY_Startup.SyncNs = PROXY_MonotonicNs();
 
-    if ((rv = nng_pair0_open(&sock)) != 0)
+    PROXY_HkTelemetryPkt.proxy_pevs_access = CFE_ES_GetAppIDByName(&proxy_evs_id, "PEVS");
+    // printf("PROXY Attempts to find PEVS: 0x%04X - %d\n", PROXY_HkTelemetryPkt.proxy_pevs_access, proxy_evs_id);
+    if (PROXY_HkTelemetryPkt.proxy_pevs_access != CFE_SUCCESS)
     {
-        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - nng_pair0_open error: %s", __func__, nng_strerror(rv));
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
+        // Can't exactly send a EVS message if this doesn't work. Not sure what else to do.
+        printf("PROXY failed to find PEVS\n");
     }
-    // Listen doesn't timeout waiting for a connection.
-    if ((rv = nng_listen(sock, IPC_PIPE_ADDRESS, NULL, 0)) !=0)
+
+    PROXY_ResetCounters();
+
+    // After PEVS, the workers report through it
+    PROXY_PoolInit();
+    PROXY_StatsInit();
+    PROXY_UsageInit();
+    PROXY_EsInit();
+
+    if (rv != 0)
     {
         CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - nng_listen error: %s", __func__, nng_strerror(rv));
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
+                                  "Proxy %s - %s error: %s", __func__, nng_call, nng_strerror(rv));
     } else {
         CFE_EVS_SendEventWithAppID(PROXY_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
                                   "PROXY listening on %s", IPC_PIPE_ADDRESS);
     }
-    if ((rv = nng_setopt_ms(sock, NNG_OPT_RECVTIMEO, ACTUAL_NNG_TIMEOUT)) != 0)
-    {
-        CFE_EVS_SendEventWithAppID(PROXY_NNG_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
-                                  "Proxy %s - nng_setopt_ms error: %s", __func__, nng_strerror(rv));
-        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
-    }
+    PROXY_LaunchReportError();
 
     CFE_EVS_SendEventWithAppID(PROXY_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
                                "Pro Proxy Initialized. Version %d.%d.%d.%d",
@@ -723,6 +1155,10 @@ void PROXY_ProcessCommandPacket(void)
             PROXY_ReportHousekeeping();
             break;
 
+        case PROXY_WAKEUP_MID:
+            PROXY_RunSlice();
+            break;
+
         default:
             PROXY_HkTelemetryPkt.proxy_command_error_count++;
             CFE_EVS_SendEventWithAppID(PROXY_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
@@ -758,6 +1194,81 @@ void PROXY_ProcessGroundCommand(void)
             PROXY_ResetCounters();
             break;
 
+        case PROXY_RECORD_START_CC:
+            if (PROXY_VerifyCmdLength(PROXY_MsgPtr, sizeof(PROXY_FilenameCmd_t)))
+            {
+                PROXY_FilenameCmd_t *cmd = (PROXY_FilenameCmd_t *) PROXY_MsgPtr;
+
+                cmd->Filename[sizeof(cmd->Filename) - 1] = '\0';
+                PROXY_HkTelemetryPkt.proxy_command_count++;
+                PROXY_RecordStart(cmd->Filename);
+            }
+            break;
+
+        case PROXY_RECORD_STOP_CC:
+            if (PROXY_VerifyCmdLength(PROXY_MsgPtr, sizeof(PROXY_NoArgsCmd_t)))
+            {
+                PROXY_HkTelemetryPkt.proxy_command_count++;
+                PROXY_RecordStop();
+            }
+            break;
+
+        case PROXY_TRACE_ENABLE_CC:
+            if (PROXY_VerifyCmdLength(PROXY_MsgPtr, sizeof(PROXY_EnableCmd_t)))
+            {
+                PROXY_HkTelemetryPkt.proxy_command_count++;
+                PROXY_TraceEnable(((PROXY_EnableCmd_t *) PROXY_MsgPtr)->Enable != 0);
+            }
+            break;
+
+        case PROXY_TRACE_DUMP_CC:
+            if (PROXY_VerifyCmdLength(PROXY_MsgPtr, sizeof(PROXY_FilenameCmd_t)))
+            {
+                PROXY_FilenameCmd_t *cmd = (PROXY_FilenameCmd_t *) PROXY_MsgPtr;
+
+                cmd->Filename[sizeof(cmd->Filename) - 1] = '\0';
+                PROXY_HkTelemetryPkt.proxy_command_count++;
+                PROXY_TraceDump(cmd->Filename);
+            }
+            break;
+
+        case PROXY_SET_WAIT_STRATEGY_CC:
+            if (PROXY_VerifyCmdLength(PROXY_MsgPtr, sizeof(PROXY_WaitStrategyCmd_t)))
+            {
+                PROXY_WaitStrategyCmd_t *cmd = (PROXY_WaitStrategyCmd_t *) PROXY_MsgPtr;
+
+                PROXY_HkTelemetryPkt.proxy_command_count++;
+                PROXY_WaitSetStrategy(cmd->Strategy, cmd->SpinMaxUs);
+            }
+            break;
+
+        case PROXY_SET_EVS_FILTER_CC:
+            if (PROXY_VerifyCmdLength(PROXY_MsgPtr, sizeof(PROXY_EvsFilterCmd_t)))
+            {
+                PROXY_EvsFilterCmd_t *cmd = (PROXY_EvsFilterCmd_t *) PROXY_MsgPtr;
+
+                PROXY_HkTelemetryPkt.proxy_command_count++;
+                PROXY_EvsSetFilter(cmd->EventID, cmd->Mask);
+            }
+            break;
+
+        case PROXY_HANDOVER_CC:
+            if (PROXY_VerifyCmdLength(PROXY_MsgPtr, sizeof(PROXY_NoArgsCmd_t)))
+            {
+                PROXY_HandoverStart();
+            }
+            break;
+
+        case PROXY_SET_USAGE_LIMITS_CC:
+            if (PROXY_VerifyCmdLength(PROXY_MsgPtr, sizeof(PROXY_UsageLimitsCmd_t)))
+            {
+                PROXY_UsageLimitsCmd_t *cmd = (PROXY_UsageLimitsCmd_t *) PROXY_MsgPtr;
+
+                PROXY_HkTelemetryPkt.proxy_command_count++;
+                PROXY_UsageSetLimits(cmd->CpuPctMax, cmd->RssKbMax);
+            }
+            break;
+
         /* default case already found during FC vs length test */
         default:
             break;
@@ -777,6 +1288,92 @@ void PROXY_ProcessGroundCommand(void)
 /* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
 void PROXY_ReportHousekeeping(void)
 {
+    PROXY_CheckLiveness();
+
+    // Tables of the actual app are managed at the housekeeping rate, like any cFS app would
+    PROXY_TblManageAll();
+
+    // Counted in the statistics page, the workers update it too
+    PROXY_HkTelemetryPkt.actual_func_calls = __atomic_load_n(&PROXY_Stats->Calls, __ATOMIC_RELAXED);
+
+    PROXY_HkTelemetryPkt.record_state  = PROXY_Record.State;
+    PROXY_HkTelemetryPkt.record_frames = PROXY_Record.Frames;
+    PROXY_HkTelemetryPkt.record_drops  = PROXY_Record.Drops;
+
+    PROXY_HkTelemetryPkt.trace_enabled = PROXY_Trace.Enabled;
+    PROXY_HkTelemetryPkt.trace_calls   = PROXY_Trace.Next;
+
+    PROXY_HkTelemetryPkt.wait_strategy        = PROXY_Wait.Strategy;
+    PROXY_HkTelemetryPkt.wait_spin_budget_us  = PROXY_Wait.SpinBudgetUs;
+    PROXY_HkTelemetryPkt.wait_spin_hits       = PROXY_Wait.SpinHits;
+    PROXY_HkTelemetryPkt.wait_block_hits      = PROXY_Wait.BlockHits;
+    PROXY_HkTelemetryPkt.wait_timeouts        = PROXY_Wait.Timeouts;
+    PROXY_HkTelemetryPkt.wait_idle_wall_ms    = PROXY_Wait.IdleWallNs / 1000000;
+    PROXY_HkTelemetryPkt.wait_idle_cpu_ms     = PROXY_Wait.IdleCpuNs / 1000000;
+    PROXY_HkTelemetryPkt.wait_poll_gap_max_us = PROXY_Wait.PollGapMaxNs / 1000;
+
+    PROXY_HkTelemetryPkt.startup_listen_us        = PROXY_StartupUs(PROXY_Startup.ListenNs);
+    PROXY_HkTelemetryPkt.startup_launch_us        = PROXY_StartupUs(PROXY_Startup.LaunchNs);
+    PROXY_HkTelemetryPkt.startup_sync_us          = PROXY_StartupUs(PROXY_Startup.SyncNs);
+    PROXY_HkTelemetryPkt.startup_connect_us       = PROXY_StartupUs(__atomic_load_n(&PROXY_Startup.ConnectNs, __ATOMIC_RELAXED));
+    PROXY_HkTelemetryPkt.startup_ready_us         = PROXY_StartupUs(PROXY_Startup.ReadyNs);
+    PROXY_HkTelemetryPkt.startup_first_runloop_us = PROXY_StartupUs(PROXY_Startup.FirstRunLoopNs);
+    PROXY_HkTelemetryPkt.actual_connects          = __atomic_load_n(&PROXY_Startup.Connects, __ATOMIC_RELAXED);
+
+    PROXY_HkTelemetryPkt.ctrl_protocol_version = PROXY_Ctrl.ProtocolVersion;
+    PROXY_HkTelemetryPkt.ctrl_features         = PROXY_Ctrl.Features;
+    PROXY_HkTelemetryPkt.ctrl_max_message_size = PROXY_Ctrl.MaxMessageSize;
+
+    PROXY_HkTelemetryPkt.tbl_count     = PROXY_TblCount;
+    PROXY_HkTelemetryPkt.tbl_refreshes = PROXY_TblRefreshes;
+
+    PROXY_HkTelemetryPkt.cds_count    = PROXY_CdsCount;
+    PROXY_HkTelemetryPkt.cds_flushes  = PROXY_CdsFlushes;
+    PROXY_HkTelemetryPkt.cds_restores = PROXY_CdsRestores;
+
+    PROXY_HkTelemetryPkt.pool_size            = PROXY_Pool.Size;
+    PROXY_HkTelemetryPkt.pool_jobs            = PROXY_Pool.Jobs;
+    PROXY_HkTelemetryPkt.pool_queue_depth     = __atomic_load_n(&PROXY_Pool.Depth, __ATOMIC_RELAXED);
+    PROXY_HkTelemetryPkt.pool_queue_depth_max = PROXY_Pool.DepthMax;
+    PROXY_HkTelemetryPkt.pool_queue_full      = PROXY_Pool.QueueFull;
+    PROXY_HkTelemetryPkt.pool_inline_waits    = PROXY_Pool.InlineWaits;
+    PROXY_HkTelemetryPkt.pool_wait_last_us    = __atomic_load_n(&PROXY_Pool.WaitLastNs, __ATOMIC_RELAXED) / 1000;
+    PROXY_HkTelemetryPkt.pool_wait_max_us     = __atomic_load_n(&PROXY_Pool.WaitMaxNs, __ATOMIC_RELAXED) / 1000;
+
+    PROXY_HkTelemetryPkt.out_queued_bytes     = PROXY_Out.Bytes;
+    PROXY_HkTelemetryPkt.out_high_water_bytes = PROXY_Out.HighWater;
+    PROXY_HkTelemetryPkt.out_queued           = PROXY_Out.Queued;
+    PROXY_HkTelemetryPkt.out_drops            = PROXY_Out.Drops;
+    PROXY_HkTelemetryPkt.out_error            = PROXY_Out.LastError;
+
+    PROXY_HkTelemetryPkt.evs_filter_local = PROXY_EvsLocal();
+    if (PROXY_Evs.Page != NULL)
+    {
+        PROXY_HkTelemetryPkt.evs_filter_count      = PROXY_Evs.Page->NumFilters;
+        PROXY_HkTelemetryPkt.evs_filter_generation = __atomic_load_n(&PROXY_Evs.Page->Generation, __ATOMIC_RELAXED);
+    }
+
+    PROXY_HkTelemetryPkt.handover_state    = PROXY_Handover.State;
+    PROXY_HkTelemetryPkt.handover_count    = PROXY_Handover.Count;
+    PROXY_HkTelemetryPkt.handover_failures = PROXY_Handover.Failures;
+
+    PROXY_HkTelemetryPkt.perf_markers = PROXY_Perf.Markers;
+    PROXY_HkTelemetryPkt.perf_dropped = PROXY_PerfDropped();
+
+    PROXY_HkTelemetryPkt.child_cpu_pct            = PROXY_Usage.CpuPct;
+    PROXY_HkTelemetryPkt.child_utime_ms           = PROXY_Usage.UtimeMs;
+    PROXY_HkTelemetryPkt.child_stime_ms           = PROXY_Usage.StimeMs;
+    PROXY_HkTelemetryPkt.child_rss_kb             = PROXY_Usage.RssKb;
+    PROXY_HkTelemetryPkt.child_min_faults         = PROXY_Usage.MinFaults;
+    PROXY_HkTelemetryPkt.child_maj_faults         = PROXY_Usage.MajFaults;
+    PROXY_HkTelemetryPkt.child_vol_ctx_switches   = PROXY_Usage.VolCtxSwitches;
+    PROXY_HkTelemetryPkt.child_invol_ctx_switches = PROXY_Usage.InvolCtxSwitches;
+    PROXY_HkTelemetryPkt.child_usage_alarms       = PROXY_Usage.Alarms;
+
+    PROXY_HkTelemetryPkt.es_queries             = PROXY_Es.Queries;
+    PROXY_HkTelemetryPkt.es_cache_hits          = PROXY_Es.Hits;
+    PROXY_HkTelemetryPkt.es_cache_invalidations = PROXY_Es.Invalidations;
+
     CFE_SB_TimeStampMsg((CFE_MSG_Message_t *) &PROXY_HkTelemetryPkt);
     CFE_SB_TransmitMsg((CFE_MSG_Message_t *) &PROXY_HkTelemetryPkt, true);
     return;
@@ -795,6 +1392,18 @@ void PROXY_ResetCounters(void)
     PROXY_HkTelemetryPkt.proxy_command_count       = 0;
     PROXY_HkTelemetryPkt.proxy_command_error_count = 0;
 
+    /* Slice statistics */
+    PROXY_HkTelemetryPkt.slice_overruns = 0;
+    PROXY_HkTelemetryPkt.slice_max_msgs = 0;
+    PROXY_HkTelemetryPkt.slice_max_us   = 0;
+
+    /* Worker pool maxima */
+    PROXY_Pool.DepthMax = 0;
+    __atomic_store_n(&PROXY_Pool.WaitMaxNs, 0, __ATOMIC_RELAXED);
+
+    /* Outbound queue high-water mark */
+    PROXY_Out.HighWater = PROXY_Out.Bytes;
+
     CFE_EVS_SendEventWithAppID(PROXY_COMMANDRST_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
                       "PROXY: RESET command");
     return;
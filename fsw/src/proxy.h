@@ -24,6 +24,11 @@
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <time.h>
+
+#include <nng/nng.h>
+
+#include "proxy_msg.h"
 
 /***********************************************************************/
 
@@ -33,6 +38,36 @@
 ** Type Definitions
 *************************************************************************/
 
+/*
+** Startup phase times, CLOCK_MONOTONIC ns (0 until the phase happens)
+*/
+typedef struct
+{
+    uint64  InitNs;           // PROXY_Init entered
+    uint64  ListenNs;         // socket listening
+    uint64  LaunchNs;         // actual app forked and exec'd
+    uint64  SyncNs;           // CFE_ES_WaitForStartupSync returned
+    uint64  ConnectNs;        // first connection from the actual app
+    uint64  ReadyNs;          // PROXY_CTRL_READY received
+    uint64  FirstRunLoopNs;   // first RunLoop call from the actual app
+    uint32  Connects;         // connections accepted
+} PROXY_Startup_t;
+
+/*
+** What a task needs to service one remote call: its flatcc builder, the socket the call
+** came from and the call's trace entry. Defined in proxy_pool.h.
+*/
+typedef struct PROXY_CallCtx PROXY_CallCtx_t;
+
+/*
+** Global data shared with the other proxy source modules
+*/
+extern proxy_hk_tlm_t PROXY_HkTelemetryPkt;
+extern CFE_ES_AppId_t proxy_evs_id;
+extern PROXY_Startup_t PROXY_Startup;
+extern pid_t childPID;
+extern nng_socket sock;
+
 /****************************************************************************/
 /*
 ** Local function prototypes.
@@ -48,8 +83,24 @@ void PROXY_ReportHousekeeping(void);
 void PROXY_ResetCounters(void);
 
 void cleanup_and_exit(uint32 RunStatus);
+void PROXY_RestartChild(void);
+int  PROXY_OpenSocket(nng_socket *Socket, const char *Address, const char **FailedCall);
 
-void incoming_message(void);
+void send_reply(const char *caller, void *flat_buffer, size_t size);
+void send_call_reply(PROXY_CallCtx_t *Ctx, const char *caller, void *flat_buffer, size_t size);
+bool incoming_message(int nng_flags);
+int  receive_message(int nng_flags, char **buffer, size_t *sz);
+void process_message(char *buffer, size_t sz);
+void process_message_from(nng_socket Sock, char *buffer, size_t sz);
+void process_remote_call(PROXY_CallCtx_t *Ctx, const char *buffer, size_t sz);
+void reject_remote_call(PROXY_CallCtx_t *Ctx, const char *buffer, size_t sz);
+bool PROXY_FunctionHasReply(uint8 Function);
+uint16 PROXY_ExpectedReplies(const void *Buffer, size_t Size);
+void PROXY_GetSupportedFunctions(uint32 *Bitmap, size_t Words);
+void PROXY_RunSlice(void);
+void PROXY_CheckLiveness(void);
+uint64 PROXY_MonotonicNs(void);
+uint32 PROXY_StartupUs(uint64 PhaseNs);
 bool PROXY_VerifyCmdLength(CFE_MSG_Message_t *MsgPtr, size_t ExpectedLength);
 
 #endif /* proxy_h */
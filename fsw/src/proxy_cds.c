@@ -0,0 +1,254 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Critical Data Store for the actual app:
+ * The proxy registers the CDS blocks (so they belong to the proxy app) and shares a mirror of
+ * each block with the client. The client updates its state in the mirror and only sends a
+ * small FLUSH frame to commit it, the block itself never goes over the socket.
+ *
+ * The registration outlives the client, so when the proxy restarts the client, and after a
+ * processor reset, the client gets its last committed state back in the mirror on REGISTER.
+ */
+
+#include "proxy_cds.h"
+#include "proxy_ctrl.h"
+#include "proxy_events.h"
+#include "proxy_shm.h"
+
+PROXY_Cds_t PROXY_CdsBlocks[PROXY_MAX_CDS];
+uint32      PROXY_CdsCount;
+uint32      PROXY_CdsFlushes;
+uint32      PROXY_CdsRestores;
+
+// Returns the block for a client handle, NULL if the handle is not valid
+static PROXY_Cds_t *PROXY_CdsFromHandle(int32 Handle)
+{
+    if (Handle < 0 || Handle >= PROXY_MAX_CDS || !PROXY_CdsBlocks[Handle].InUse)
+    {
+        return NULL;
+    }
+
+    return &PROXY_CdsBlocks[Handle];
+}
+
+static void PROXY_CdsUnmap(PROXY_Cds_t *Cds)
+{
+    PROXY_ShmDestroy(Cds->Mirror, Cds->Size, Cds->ShmName);
+    Cds->InUse = false;
+    PROXY_CdsCount--;
+}
+
+// Maps the mirror of a new block, returns false (and reports) on error
+static bool PROXY_CdsMapShm(PROXY_Cds_t *Cds)
+{
+    snprintf(Cds->ShmName, sizeof(Cds->ShmName), "%s_cds_%s", PROXY_SHM_PREFIX, Cds->Name);
+
+    // Only the proxy and the client (same user) may write the mirror
+    Cds->Mirror = PROXY_ShmCreate(Cds->ShmName, Cds->Size, 0600, PROXY_CDS_ERR_EID);
+    if (Cds->Mirror == NULL)
+    {
+        return false;
+    }
+
+    // An object left by an earlier proxy is reused, the mirror of a new block starts zeroed
+    memset(Cds->Mirror, 0, Cds->Size);
+
+    return true;
+}
+
+// Copies the committed contents into the mirror
+static int32 PROXY_CdsRestore(PROXY_Cds_t *Cds)
+{
+    int32 status = CFE_ES_RestoreFromCDS(Cds->Mirror, Cds->CDSHandle);
+
+    if (status == CFE_SUCCESS)
+    {
+        PROXY_CdsRestores++;
+    }
+    else
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_CDS_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: restore of CDS %s failed: 0x%08X", Cds->Name, (unsigned int) status);
+    }
+
+    return status;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_CdsRegister                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Registers a block (or finds the one an earlier client registered)  */
+/*         and maps its mirror, restoring the committed contents if there     */
+/*         are any.                                                           */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static void PROXY_CdsRegister(const PROXY_CtrlCdsRegister_t *Cmd, PROXY_CtrlCdsReply_t *Reply)
+{
+    char         Name[PROXY_CDS_NAME_LEN];
+    PROXY_Cds_t *Cds  = NULL;
+    PROXY_Cds_t *Free = NULL;
+    int32        index;
+
+    memcpy(Name, Cmd->Name, sizeof(Name));
+    Name[sizeof(Name) - 1] = '\0';
+
+    for (index = 0; index < PROXY_MAX_CDS; index++)
+    {
+        if (!PROXY_CdsBlocks[index].InUse)
+        {
+            if (Free == NULL)
+            {
+                Free = &PROXY_CdsBlocks[index];
+            }
+        }
+        else if (strcmp(PROXY_CdsBlocks[index].Name, Name) == 0)
+        {
+            Cds = &PROXY_CdsBlocks[index];
+            break;
+        }
+    }
+
+    if (Cds != NULL)
+    {
+        if (Cds->Size == Cmd->Size)
+        {
+            // Registered by an earlier instance of the client, hand back the committed state
+            Reply->Status   = PROXY_CdsRestore(Cds);
+            Reply->Restored = (Reply->Status == CFE_SUCCESS);
+            Reply->Handle   = Cds - PROXY_CdsBlocks;
+            return;
+        }
+
+        // The size changed, cFE discards the old contents on registration
+        PROXY_CdsUnmap(Cds);
+        Free = Cds;
+    }
+
+    if (Free == NULL)
+    {
+        Reply->Status = CFE_ES_NO_RESOURCE_IDS_AVAILABLE;
+        return;
+    }
+    Cds = Free;
+
+    Reply->Status = CFE_ES_RegisterCDS(&Cds->CDSHandle, Cmd->Size, Name);
+    if (Reply->Status != CFE_SUCCESS && Reply->Status != CFE_ES_CDS_ALREADY_EXISTS)
+    {
+        return;
+    }
+
+    strncpy(Cds->Name, Name, sizeof(Cds->Name));
+    Cds->Size = Cmd->Size;
+    if (!PROXY_CdsMapShm(Cds))
+    {
+        Reply->Status = CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+        return;
+    }
+    Cds->InUse = true;
+    PROXY_CdsCount++;
+
+    if (Reply->Status == CFE_ES_CDS_ALREADY_EXISTS)
+    {
+        // Survived a reset; on a failed restore the client starts from a zeroed mirror
+        Reply->Restored = (PROXY_CdsRestore(Cds) == CFE_SUCCESS);
+    }
+
+    Reply->Handle = Cds - PROXY_CdsBlocks;
+} /* End of PROXY_CdsRegister() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_CdsProcessCtrl                                               */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Handles the PROXY_CTRL_CDS_* control frames, each is answered with */
+/*         a PROXY_CTRL_CDS_REPLY.                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_CdsProcessCtrl(const void *Buffer, size_t Size)
+{
+    const PROXY_CtrlHdr_t       *Hdr = Buffer;
+    const PROXY_CtrlCdsHandle_t *Cmd = Buffer;
+    PROXY_CtrlCdsReply_t         Reply;
+    PROXY_Cds_t                 *Cds;
+
+    memset(&Reply, 0, sizeof(Reply));
+    PROXY_CtrlInitHdr(&Reply.Hdr, PROXY_CTRL_CDS_REPLY, sizeof(Reply));
+    Reply.Handle = -1;
+
+    // Gated like a batch, the client still gets its reply so it fails fast
+    if ((PROXY_CtrlFeatures() & PROXY_FEATURE_SHM_CDS) == 0)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_CDS_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: CDS frame %u received but not negotiated", (unsigned int) Hdr->Type);
+        Reply.Status = CFE_STATUS_NOT_IMPLEMENTED;
+        send_reply(__func__, &Reply, sizeof(Reply));
+        return;
+    }
+
+    if (Hdr->Type == PROXY_CTRL_CDS_REGISTER)
+    {
+        if (!PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlCdsRegister_t)))
+        {
+            return;
+        }
+        PROXY_CdsRegister(Buffer, &Reply);
+    }
+    else
+    {
+        if (!PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlCdsHandle_t)))
+        {
+            return;
+        }
+        Reply.Handle = Cmd->Handle;
+
+        Cds = PROXY_CdsFromHandle(Cmd->Handle);
+        if (Cds == NULL)
+        {
+            Reply.Status = CFE_ES_ERR_RESOURCEID_NOT_VALID;
+        }
+        else if (Hdr->Type == PROXY_CTRL_CDS_FLUSH)
+        {
+            Reply.Status = CFE_ES_CopyToCDS(Cds->CDSHandle, Cds->Mirror);
+            if (Reply.Status == CFE_SUCCESS)
+            {
+                PROXY_CdsFlushes++;
+            }
+        }
+        else
+        {
+            Reply.Status   = PROXY_CdsRestore(Cds);
+            Reply.Restored = (Reply.Status == CFE_SUCCESS);
+        }
+    }
+
+    Cds = PROXY_CdsFromHandle(Reply.Handle);
+    if (Cds != NULL)
+    {
+        Reply.Size = Cds->Size;
+        strncpy(Reply.ShmName, Cds->ShmName, sizeof(Reply.ShmName) - 1);
+    }
+
+    send_reply(__func__, &Reply, sizeof(Reply));
+} /* End of PROXY_CdsProcessCtrl() */
+
+// Removes the mirrors at exit, the blocks stay in the CDS for the next start
+void PROXY_CdsCleanup(void)
+{
+    int32 index;
+
+    for (index = 0; index < PROXY_MAX_CDS; index++)
+    {
+        if (PROXY_CdsBlocks[index].InUse)
+        {
+            PROXY_CdsUnmap(&PROXY_CdsBlocks[index]);
+        }
+    }
+}
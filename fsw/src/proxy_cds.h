@@ -0,0 +1,40 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_cds_h
+#define proxy_cds_h
+
+#include "proxy.h"
+#include "proxy_ipc.h"
+#include "proxy_defs.h"
+
+/*
+** A CDS block registered on behalf of the actual app
+*/
+typedef struct
+{
+    bool               InUse;
+    CFE_ES_CDSHandle_t CDSHandle;
+    char               Name[PROXY_CDS_NAME_LEN];
+    uint32             Size;
+    char               ShmName[PROXY_SHM_NAME_LEN];
+    void              *Mirror;         // shared read-write with the client
+} PROXY_Cds_t;
+
+extern PROXY_Cds_t PROXY_CdsBlocks[PROXY_MAX_CDS];
+extern uint32      PROXY_CdsCount;
+extern uint32      PROXY_CdsFlushes;
+extern uint32      PROXY_CdsRestores;
+
+void PROXY_CdsProcessCtrl(const void *Buffer, size_t Size);
+void PROXY_CdsCleanup(void);
+
+#endif /* proxy_cds_h */
@@ -0,0 +1,349 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Control frames from the client (see proxy_ipc.h)
+ */
+
+#include "proxy_ctrl.h"
+#include "proxy_tbl.h"
+#include "proxy_cds.h"
+#include "proxy_pool.h"
+#include "proxy_evs.h"
+#include "proxy_perf.h"
+#include "proxy_es.h"
+#include "proxy_handover.h"
+#include "proxy_stats.h"
+#include "proxy_events.h"
+#include "proxy_defs.h"
+
+PROXY_Ctrl_t PROXY_Ctrl = { .MaxMessageSize = PROXY_MAX_MESSAGE_SIZE };
+
+// Set on an nng thread when the actual app disconnects
+static bool PROXY_CtrlStale;
+
+// Forgets what was negotiated, a new actual app gets the features of its own HELLO only
+void PROXY_CtrlReset(PROXY_Ctrl_t *Ctrl)
+{
+    Ctrl->ProtocolVersion = 0;
+    Ctrl->Features        = 0;
+    Ctrl->MaxMessageSize  = PROXY_MAX_MESSAGE_SIZE;
+}
+
+// What was negotiated on Sock. The replacement of a starting handover negotiates apart from
+// the actual app, which keeps its own features if the handover is aborted.
+PROXY_Ctrl_t *PROXY_CtrlOf(nng_socket Sock)
+{
+    if (PROXY_Handover.State == PROXY_HANDOVER_STARTING && PROXY_HandoverStandby(Sock))
+    {
+        return &PROXY_Handover.Ctrl;
+    }
+
+    return &PROXY_Ctrl;
+}
+
+// Features of the client whose control frame the proxy task is servicing
+uint32 PROXY_CtrlFeatures(void)
+{
+    return PROXY_CtrlOf(PROXY_MainCtx.Sock)->Features;
+}
+
+// May run on an nng thread, the reset is done by PROXY_CtrlPoll on the proxy task
+void PROXY_CtrlDisconnected(void)
+{
+    __atomic_store_n(&PROXY_CtrlStale, true, __ATOMIC_RELEASE);
+}
+
+// Called before each message, so whatever connects after a disconnect starts afresh
+void PROXY_CtrlPoll(void)
+{
+    if (__atomic_exchange_n(&PROXY_CtrlStale, false, __ATOMIC_ACQ_REL))
+    {
+        PROXY_CtrlReset(&PROXY_Ctrl);
+    }
+}
+
+void PROXY_CtrlInitHdr(PROXY_CtrlHdr_t *Hdr, uint16 Type, size_t Length)
+{
+    Hdr->Magic  = PROXY_CTRL_MAGIC;
+    Hdr->Type   = Type;
+    Hdr->Length = Length;
+}
+
+// Tells the client a frame of this type can not be handled
+void PROXY_CtrlError(uint16 Type, int32 Status)
+{
+    PROXY_CtrlError_t Error;
+
+    memset(&Error, 0, sizeof(Error));
+    PROXY_CtrlInitHdr(&Error.Hdr, PROXY_CTRL_ERROR, sizeof(Error));
+    Error.Type   = Type;
+    Error.Status = Status;
+
+    send_reply(__func__, &Error, sizeof(Error));
+}
+
+// Returns false (and reports) if the frame is shorter than the type requires. The client
+// gets a PROXY_CTRL_ERROR instead of the reply it waits for, READY has no reply at all.
+bool PROXY_CtrlCheckLength(const PROXY_CtrlHdr_t *Hdr, size_t Size, size_t Expected)
+{
+    if (Size < Expected || Hdr->Length < Expected)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_CTRL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: control frame %u too short: %u bytes, expected %u",
+                                   (unsigned int) Hdr->Type, (unsigned int) Size, (unsigned int) Expected);
+        if (Hdr->Type != PROXY_CTRL_READY)
+        {
+            PROXY_CtrlError(Hdr->Type, CFE_STATUS_WRONG_MSG_LENGTH);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+static void PROXY_CtrlReady(const PROXY_CtrlReady_t *Ready)
+{
+    uint64 now = PROXY_MonotonicNs();
+
+    if (PROXY_Startup.ReadyNs == 0)
+    {
+        PROXY_Startup.ReadyNs = now;
+    }
+
+    CFE_EVS_SendEventWithAppID(PROXY_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: actual app ready, pid %u, %u ms after proxy init",
+                               (unsigned int) Ready->Pid, (unsigned int) ((now - PROXY_Startup.InitNs) / 1000000));
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_CtrlHello                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Negotiates the protocol with the client: features both sides      */
+/*         support, the smaller of the message size limits, and the list of   */
+/*         implemented functions.                                             */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static void PROXY_CtrlHello(const PROXY_CtrlHello_t *Hello)
+{
+    PROXY_CtrlCapabilities_t Caps;
+    PROXY_Ctrl_t            *Ctrl = PROXY_CtrlOf(PROXY_MainCtx.Sock);
+
+    Ctrl->ProtocolVersion = Hello->ProtocolVersion;
+
+    // A client speaking another version only gets the base RemoteCall protocol
+    Ctrl->Features = 0;
+    if (Hello->ProtocolVersion == PROXY_PROTOCOL_VERSION)
+    {
+        Ctrl->Features = Hello->Features & PROXY_FEATURES_SUPPORTED;
+    }
+    if ((Ctrl->Features & PROXY_FEATURE_EVS_FILTER) && !PROXY_EvsMapPage())
+    {
+        Ctrl->Features &= ~PROXY_FEATURE_EVS_FILTER;
+    }
+    if ((Ctrl->Features & PROXY_FEATURE_PERF_RING) &&
+        !PROXY_PerfMapRing(PROXY_HandoverEndpoint(PROXY_MainCtx.Sock)))
+    {
+        Ctrl->Features &= ~PROXY_FEATURE_PERF_RING;
+    }
+    if ((Ctrl->Features & PROXY_FEATURE_ES_CACHE) && !PROXY_EsMapPage())
+    {
+        Ctrl->Features &= ~PROXY_FEATURE_ES_CACHE;
+    }
+
+    // A batch can not be longer than a control frame
+    Ctrl->MaxMessageSize = PROXY_MAX_MESSAGE_SIZE;
+    if (Ctrl->MaxMessageSize > PROXY_CTRL_MAX_LENGTH)
+    {
+        Ctrl->MaxMessageSize = PROXY_CTRL_MAX_LENGTH;
+    }
+    if (Hello->MaxMessageSize != 0 && Hello->MaxMessageSize < Ctrl->MaxMessageSize)
+    {
+        Ctrl->MaxMessageSize = Hello->MaxMessageSize;
+    }
+
+    memset(&Caps, 0, sizeof(Caps));
+    PROXY_CtrlInitHdr(&Caps.Hdr, PROXY_CTRL_CAPABILITIES, sizeof(Caps));
+    Caps.ProtocolVersion = PROXY_PROTOCOL_VERSION;
+    Caps.Features        = Ctrl->Features;
+    Caps.MaxMessageSize  = Ctrl->MaxMessageSize;
+    PROXY_GetSupportedFunctions(Caps.Functions, PROXY_FUNCTION_WORDS);
+
+    send_reply(__func__, &Caps, sizeof(Caps));
+
+    CFE_EVS_SendEventWithAppID(PROXY_STARTUP_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: client protocol %u, features 0x%08X, max message %u",
+                               (unsigned int) Hello->ProtocolVersion, (unsigned int) Ctrl->Features,
+                               (unsigned int) Ctrl->MaxMessageSize);
+} /* End of PROXY_CtrlHello() */
+
+// Returns the batch entry at *Offset and moves *Offset to the next one, NULL if the entry overruns the frame
+const PROXY_CtrlBatchEntry_t *PROXY_CtrlBatchEntry(const PROXY_CtrlBatch_t *Batch, size_t Size, size_t *Offset)
+{
+    const PROXY_CtrlBatchEntry_t *Entry = (const PROXY_CtrlBatchEntry_t *) ((const uint8 *) Batch + *Offset);
+
+    if (*Offset + sizeof(*Entry) > Size || Entry->Length > Size - *Offset - sizeof(*Entry))
+    {
+        return NULL;
+    }
+
+    *Offset += sizeof(*Entry) + ((Entry->Length + PROXY_BATCH_ALIGN - 1) & ~(PROXY_BATCH_ALIGN - 1));
+
+    return Entry;
+}
+
+// Returns the index of the first entry that overruns the frame, Count if every entry fits
+uint16 PROXY_CtrlBatchCheck(const PROXY_CtrlBatch_t *Batch, size_t Size)
+{
+    size_t offset = sizeof(PROXY_CtrlBatch_t);
+    uint16 index;
+
+    for (index = 0; index < Batch->Count; index++)
+    {
+        if (PROXY_CtrlBatchEntry(Batch, Size, &offset) == NULL)
+        {
+            break;
+        }
+    }
+
+    return index;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_CtrlBatch                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Services each RemoteCall of a batch frame in order, on the proxy   */
+/*         task or on a worker. A malformed batch is rejected as a whole with */
+/*         one PROXY_CTRL_ERROR, none of its calls is run.                    */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_CtrlBatch(PROXY_CallCtx_t *Ctx, const PROXY_CtrlBatch_t *Batch, size_t Size)
+{
+    const PROXY_CtrlBatchEntry_t *Entry;
+    size_t offset = sizeof(PROXY_CtrlBatch_t);
+    uint16 index;
+
+    bool   negotiated = (PROXY_CtrlOf(Ctx->Sock)->Features & PROXY_FEATURE_BATCH) != 0;
+
+    index = PROXY_CtrlBatchCheck(Batch, Size);
+    if (index < Batch->Count)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_CTRL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: batch entry %u of %u overruns the frame",
+                                   (unsigned int) index, (unsigned int) Batch->Count);
+        PROXY_CtrlError(PROXY_CTRL_BATCH, CFE_STATUS_WRONG_MSG_LENGTH);
+        return;
+    }
+
+    if (!negotiated)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_CTRL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: batch received but not negotiated");
+    }
+
+    for (index = 0; index < Batch->Count; index++)
+    {
+        Entry = PROXY_CtrlBatchEntry(Batch, Size, &offset);
+
+        // Without the feature each call still gets its reply, so the client fails fast
+        if (negotiated)
+        {
+            process_remote_call(Ctx, (const char *) (Entry + 1), Entry->Length);
+        }
+        else
+        {
+            reject_remote_call(Ctx, (const char *) (Entry + 1), Entry->Length);
+        }
+    }
+} /* End of PROXY_CtrlBatch() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_ProcessCtrlFrame                                             */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Handles one control frame received from the actual app.            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_ProcessCtrlFrame(const void *Buffer, size_t Size)
+{
+    const PROXY_CtrlHdr_t *Hdr = Buffer;
+
+    PROXY_StatsCount(&PROXY_Stats->CtrlFrames);
+
+    // Longer than PROXY_CTRL_MAX_LENGTH, its Length has wrapped and can not be trusted
+    if (Size > PROXY_CTRL_MAX_LENGTH)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_CTRL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: control frame %u too long: %u bytes", (unsigned int) Hdr->Type,
+                                   (unsigned int) Size);
+        if (Hdr->Type != PROXY_CTRL_READY)
+        {
+            PROXY_CtrlError(Hdr->Type, CFE_STATUS_WRONG_MSG_LENGTH);
+        }
+        return;
+    }
+
+    switch (Hdr->Type)
+    {
+        case PROXY_CTRL_READY:
+            if (PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlReady_t)))
+            {
+                PROXY_CtrlReady(Buffer);
+            }
+            break;
+
+        case PROXY_CTRL_HELLO:
+            if (PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlHello_t)))
+            {
+                PROXY_CtrlHello(Buffer);
+            }
+            break;
+
+        case PROXY_CTRL_BATCH:
+            if (PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlBatch_t)))
+            {
+                PROXY_CtrlBatch(&PROXY_MainCtx, Buffer, Size);
+            }
+            break;
+
+        case PROXY_CTRL_TBL_REGISTER:
+        case PROXY_CTRL_TBL_LOAD:
+        case PROXY_CTRL_TBL_GET_ADDRESS:
+        case PROXY_CTRL_TBL_RELEASE_ADDRESS:
+        case PROXY_CTRL_TBL_MANAGE:
+            PROXY_TblProcessCtrl(Buffer, Size);
+            break;
+
+        case PROXY_CTRL_CDS_REGISTER:
+        case PROXY_CTRL_CDS_FLUSH:
+        case PROXY_CTRL_CDS_RESTORE:
+            PROXY_CdsProcessCtrl(Buffer, Size);
+            break;
+
+        case PROXY_CTRL_EVS_MAP:
+            PROXY_EvsProcessCtrl(Buffer, Size);
+            break;
+
+        case PROXY_CTRL_PERF_MAP:
+            PROXY_PerfProcessCtrl(Buffer, Size);
+            break;
+
+        case PROXY_CTRL_ES_QUERY:
+        case PROXY_CTRL_ES_MAP:
+            PROXY_EsProcessCtrl(Buffer, Size);
+            break;
+
+        default:
+            CFE_EVS_SendEventWithAppID(PROXY_CTRL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                       "PROXY: unknown control frame type %u", (unsigned int) Hdr->Type);
+            PROXY_CtrlError(Hdr->Type, CFE_STATUS_NOT_IMPLEMENTED);
+            break;
+    }
+} /* End of PROXY_ProcessCtrlFrame() */
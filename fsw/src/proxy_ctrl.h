@@ -0,0 +1,52 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_ctrl_h
+#define proxy_ctrl_h
+
+#include "proxy.h"
+#include "proxy_ipc.h"
+
+// Features this proxy can offer in PROXY_CTRL_CAPABILITIES
+#define PROXY_FEATURES_SUPPORTED    (PROXY_FEATURE_BATCH | PROXY_FEATURE_SHM_TABLES | PROXY_FEATURE_SHM_CDS | \
+                                     PROXY_FEATURE_EVS_FILTER | PROXY_FEATURE_PERF_RING | PROXY_FEATURE_ES_CACHE)
+
+/*
+** What was negotiated with the client
+*/
+typedef struct
+{
+    uint16  ProtocolVersion;    // of the client, 0 until its HELLO
+    uint32  Features;           // PROXY_FEATURE_* both sides support
+    uint32  MaxMessageSize;     // largest message either side may send
+} PROXY_Ctrl_t;
+
+extern PROXY_Ctrl_t PROXY_Ctrl;
+
+static inline bool PROXY_IsCtrlFrame(const void *Buffer, size_t Size)
+{
+    return Size >= sizeof(PROXY_CtrlHdr_t) && ((const PROXY_CtrlHdr_t *) Buffer)->Magic == PROXY_CTRL_MAGIC;
+}
+
+void PROXY_CtrlReset(PROXY_Ctrl_t *Ctrl);
+PROXY_Ctrl_t *PROXY_CtrlOf(nng_socket Sock);
+uint32 PROXY_CtrlFeatures(void);
+void PROXY_CtrlDisconnected(void);
+void PROXY_CtrlPoll(void);
+void PROXY_ProcessCtrlFrame(const void *Buffer, size_t Size);
+void PROXY_CtrlInitHdr(PROXY_CtrlHdr_t *Hdr, uint16 Type, size_t Length);
+void PROXY_CtrlError(uint16 Type, int32 Status);
+bool PROXY_CtrlCheckLength(const PROXY_CtrlHdr_t *Hdr, size_t Size, size_t Expected);
+uint16 PROXY_CtrlBatchCheck(const PROXY_CtrlBatch_t *Batch, size_t Size);
+const PROXY_CtrlBatchEntry_t *PROXY_CtrlBatchEntry(const PROXY_CtrlBatch_t *Batch, size_t Size, size_t *Offset);
+void PROXY_CtrlBatch(PROXY_CallCtx_t *Ctx, const PROXY_CtrlBatch_t *Batch, size_t Size);
+
+#endif /* proxy_ctrl_h */
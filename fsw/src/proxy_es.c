@@ -0,0 +1,352 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * ES query cache:
+ * CFE_ES_GetAppIDByName and CFE_ES_GetResetType only change when ES starts, stops, restarts
+ * or reloads an app, and ES reports each of those with an event. The proxy keeps the results
+ * of those queries of the actual app keyed by name, and empties the cache whenever an event
+ * of ES arrives on its event pipe. The pipe is drained once per pass of the run loop and
+ * before each query. CFE_ES_GetAppInfo and CFE_ES_GetTaskInfo are always asked of ES, since
+ * their ExecutionCounter and NumOfChildTasks change without any event.
+ *
+ * An event that is lost (a full pipe, EVS not sending long events) would leave entries that
+ * are no longer right, so entries are also dropped once they are older than
+ * PROXY_ES_CACHE_MAX_AGE_MS. The generation of the cache is published in a page the client
+ * maps read-only, which lets it keep replies itself (see proxy_ipc.h).
+ */
+
+#include "proxy_es.h"
+#include "proxy_ctrl.h"
+#include "proxy_events.h"
+#include "proxy_shm.h"
+
+#include "cfe_msgids.h"
+
+#include <stddef.h>
+
+PROXY_Es_t PROXY_Es;
+
+// Empties the cache and tells the clients their replies are stale
+static void PROXY_EsInvalidate(void)
+{
+    memset(PROXY_Es.Entries, 0, sizeof(PROXY_Es.Entries));
+    PROXY_Es.Next = 0;
+    PROXY_Es.Generation++;
+    PROXY_Es.Invalidations++;
+
+    if (PROXY_Es.Page != NULL)
+    {
+        __atomic_store_n(&PROXY_Es.Page->Generation, PROXY_Es.Generation, __ATOMIC_RELEASE);
+    }
+}
+
+void PROXY_EsInit(void)
+{
+    int32 status;
+
+    if (PROXY_ES_CACHE_SIZE == 0)
+    {
+        return;
+    }
+
+    status = CFE_SB_CreatePipe(&PROXY_Es.EventPipe, PROXY_ES_PIPE_DEPTH, "PROXY_ES_PIPE");
+    if (status == CFE_SUCCESS)
+    {
+        // Events come in bursts, take as many as the pipe holds
+        status = CFE_SB_SubscribeEx(CFE_SB_ValueToMsgId(CFE_EVS_LONG_EVENT_MSG_MID), PROXY_Es.EventPipe,
+                                    CFE_SB_DEFAULT_QOS, PROXY_ES_PIPE_DEPTH);
+        PROXY_Es.PipeCreated = true;
+    }
+
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_ES_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: ES event pipe failed: 0x%08X, ES queries are not cached",
+                                   (unsigned int) status);
+        PROXY_Es.PipeCreated = false;
+    }
+}
+
+// Takes the events that arrived, any event of ES empties the cache
+void PROXY_EsPoll(void)
+{
+    const CFE_EVS_LongEventTlm_t *Event;
+    CFE_SB_Buffer_t *Buffer;
+    bool stale = false;
+
+    if (!PROXY_Es.PipeCreated)
+    {
+        return;
+    }
+
+    while (CFE_SB_ReceiveBuffer(&Buffer, PROXY_Es.EventPipe, CFE_SB_POLL) == CFE_SUCCESS)
+    {
+        Event = (const CFE_EVS_LongEventTlm_t *) Buffer;
+        if (strncmp(Event->Payload.PacketID.AppName, "CFE_ES", sizeof(Event->Payload.PacketID.AppName)) == 0)
+        {
+            stale = true;
+        }
+    }
+
+    if (stale)
+    {
+        PROXY_EsInvalidate();
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_EsMapPage                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Creates the generation page the first time the feature is          */
+/*         negotiated. Returns false (and reports) if it can not be created,  */
+/*         the feature is then not offered.                                   */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+bool PROXY_EsMapPage(void)
+{
+    if (!PROXY_Es.PipeCreated)
+    {
+        return false;
+    }
+    if (PROXY_Es.Page != NULL)
+    {
+        return true;
+    }
+
+    snprintf(PROXY_Es.ShmName, sizeof(PROXY_Es.ShmName), "%s_es", PROXY_SHM_PREFIX);
+
+    PROXY_Es.Page = PROXY_ShmCreate(PROXY_Es.ShmName, sizeof(PROXY_ShmEs_t), 0644, PROXY_ES_ERR_EID);
+    if (PROXY_Es.Page == NULL)
+    {
+        return false;
+    }
+
+    PROXY_Es.Page->MaxAgeMs = PROXY_ES_CACHE_MAX_AGE_MS;
+    __atomic_store_n(&PROXY_Es.Page->Generation, PROXY_Es.Generation, __ATOMIC_RELEASE);
+
+    return true;
+} /* End of PROXY_EsMapPage() */
+
+// The entry holding the answer to a query, NULL if there is none or it is too old
+static PROXY_EsEntry_t *PROXY_EsFind(uint16 Query, uint32 Id, const char *Name)
+{
+    PROXY_EsEntry_t *Entry;
+    uint64 oldest = PROXY_MonotonicNs() - (uint64) PROXY_ES_CACHE_MAX_AGE_MS * 1000000;
+    uint32 index;
+
+    for (index = 0; index < PROXY_ES_CACHE_SIZE; index++)
+    {
+        Entry = &PROXY_Es.Entries[index];
+        if (Entry->Query == Query && Entry->Id == Id && strcmp(Entry->Name, Name) == 0)
+        {
+            if (Entry->FetchedNs < oldest)
+            {
+                Entry->Query = 0;
+                return NULL;
+            }
+            return Entry;
+        }
+    }
+
+    return NULL;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_EsFetch                                                      */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Asks ES, filling Entry with the result. The info structures are    */
+/*         copied as they are, the client has the same cFE build.             */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+static void PROXY_EsFetch(PROXY_EsEntry_t *Entry)
+{
+    CFE_ES_AppId_t AppId;
+    union
+    {
+        CFE_ES_AppInfo_t  App;
+        CFE_ES_TaskInfo_t Task;
+    } Info;
+
+    Entry->FetchedNs = PROXY_MonotonicNs();
+    Entry->Result    = 0;
+    Entry->InfoSize  = 0;
+
+    switch (Entry->Query)
+    {
+        case PROXY_ES_APP_ID_BY_NAME:
+            Entry->Status = CFE_ES_GetAppIDByName(&AppId, Entry->Name);
+            if (Entry->Status == CFE_SUCCESS)
+            {
+                Entry->Result = CFE_ResourceId_ToInteger(AppId);
+            }
+            break;
+
+        case PROXY_ES_APP_INFO:
+            Entry->Status = CFE_ES_GetAppInfo(&Info.App, CFE_ResourceId_FromInteger(Entry->Id));
+            Entry->InfoSize = sizeof(Info.App);
+            break;
+
+        case PROXY_ES_TASK_INFO:
+            Entry->Status = CFE_ES_GetTaskInfo(&Info.Task, CFE_ResourceId_FromInteger(Entry->Id));
+            Entry->InfoSize = sizeof(Info.Task);
+            break;
+
+        case PROXY_ES_RESET_TYPE:
+            Entry->Status = CFE_ES_GetResetType(&Entry->Result);
+            break;
+
+        default:
+            Entry->Status = CFE_STATUS_NOT_IMPLEMENTED;
+            break;
+    }
+
+    if (Entry->InfoSize > sizeof(Entry->Info))
+    {
+        Entry->Status   = CFE_STATUS_NOT_IMPLEMENTED;
+        Entry->InfoSize = 0;
+    }
+    memcpy(Entry->Info, &Info, Entry->InfoSize);
+} /* End of PROXY_EsFetch() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_EsQuery                                                      */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Answers a PROXY_CTRL_ES_QUERY from the cache, asking ES and        */
+/*         keeping the result when it is not there. App and task info are     */
+/*         always asked of ES and never kept.                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+static void PROXY_EsQuery(const PROXY_CtrlEsQuery_t *Query, PROXY_CtrlEsReply_t *Reply)
+{
+    PROXY_EsEntry_t *Entry;
+    PROXY_EsEntry_t  Uncached;
+    char   name[PROXY_ES_NAME_LEN + 1] = "";
+    uint32 id = 0;
+    bool   cacheable = PROXY_ES_CACHE_SIZE > 0 &&
+                       (Query->Query == PROXY_ES_APP_ID_BY_NAME || Query->Query == PROXY_ES_RESET_TYPE);
+
+    // The key is the name or the ID, whichever the query uses
+    if (Query->Query == PROXY_ES_APP_ID_BY_NAME)
+    {
+        memcpy(name, Query->Name, sizeof(Query->Name));
+    }
+    else if (Query->Query != PROXY_ES_RESET_TYPE)
+    {
+        id = Query->Id;
+    }
+
+    PROXY_EsPoll();
+    PROXY_Es.Queries++;
+
+    Entry = cacheable ? PROXY_EsFind(Query->Query, id, name) : NULL;
+    if (Entry != NULL)
+    {
+        PROXY_Es.Hits++;
+        Reply->Cached = 1;
+    }
+    else
+    {
+        Entry = cacheable ? &PROXY_Es.Entries[PROXY_Es.Next] : &Uncached;
+        memset(Entry, 0, sizeof(*Entry));
+        Entry->Query = Query->Query;
+        Entry->Id    = id;
+        strcpy(Entry->Name, name);
+        PROXY_EsFetch(Entry);
+
+        if (cacheable)
+        {
+            PROXY_Es.Next = (PROXY_Es.Next + 1) % PROXY_ES_CACHE_SIZE;
+        }
+    }
+
+    Reply->Query      = Entry->Query;
+    Reply->Status     = Entry->Status;
+    Reply->Generation = PROXY_Es.Generation;
+    Reply->InfoSize   = Entry->InfoSize;
+    memcpy(Reply->Info, Entry->Info, Entry->InfoSize);
+
+    if (Entry->Query == PROXY_ES_RESET_TYPE)
+    {
+        Reply->ResetSubtype = Entry->Result;
+    }
+    else
+    {
+        Reply->Id = Entry->Result;
+    }
+} /* End of PROXY_EsQuery() */
+
+// Answers PROXY_CTRL_ES_QUERY and PROXY_CTRL_ES_MAP
+void PROXY_EsProcessCtrl(const void *Buffer, size_t Size)
+{
+    const PROXY_CtrlHdr_t     *Hdr = Buffer;
+    const PROXY_CtrlEsQuery_t *Query;
+    PROXY_CtrlEsMapReply_t MapReply;
+    PROXY_CtrlEsReply_t    Reply;
+    size_t length;
+
+    if (Hdr->Type == PROXY_CTRL_ES_MAP)
+    {
+        if (!PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlEsMap_t)))
+        {
+            return;
+        }
+
+        memset(&MapReply, 0, sizeof(MapReply));
+        PROXY_CtrlInitHdr(&MapReply.Hdr, PROXY_CTRL_ES_MAP_REPLY, sizeof(MapReply));
+        if ((PROXY_CtrlFeatures() & PROXY_FEATURE_ES_CACHE) && PROXY_Es.Page != NULL)
+        {
+            MapReply.Status = CFE_SUCCESS;
+            strncpy(MapReply.ShmName, PROXY_Es.ShmName, sizeof(MapReply.ShmName) - 1);
+        }
+        else
+        {
+            MapReply.Status = CFE_STATUS_NOT_IMPLEMENTED;
+        }
+
+        send_reply(__func__, &MapReply, sizeof(MapReply));
+        return;
+    }
+
+    if (!PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlEsQuery_t)))
+    {
+        return;
+    }
+
+    Query = Buffer;
+
+    memset(&Reply, 0, offsetof(PROXY_CtrlEsReply_t, Info));
+    if ((PROXY_CtrlFeatures() & PROXY_FEATURE_ES_CACHE) &&
+        Query->Query >= PROXY_ES_APP_ID_BY_NAME && Query->Query <= PROXY_ES_RESET_TYPE)
+    {
+        PROXY_EsQuery(Query, &Reply);
+    }
+    else
+    {
+        Reply.Query  = Query->Query;
+        Reply.Status = CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    // Most replies carry no info, only send what there is
+    length = offsetof(PROXY_CtrlEsReply_t, Info) + Reply.InfoSize;
+    PROXY_CtrlInitHdr(&Reply.Hdr, PROXY_CTRL_ES_REPLY, length);
+
+    send_reply(__func__, &Reply, length);
+}
+
+void PROXY_EsCleanup(void)
+{
+    if (PROXY_Es.Page != NULL)
+    {
+        PROXY_ShmDestroy(PROXY_Es.Page, sizeof(PROXY_ShmEs_t), PROXY_Es.ShmName);
+        PROXY_Es.Page = NULL;
+    }
+}
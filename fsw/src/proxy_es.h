@@ -0,0 +1,56 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_es_h
+#define proxy_es_h
+
+#include "proxy.h"
+#include "proxy_ipc.h"
+#include "proxy_defs.h"
+
+typedef struct
+{
+    uint16  Query;          // PROXY_ES_*, 0 for a free entry
+    uint32  Id;             // key of APP_INFO and TASK_INFO
+    char    Name[PROXY_ES_NAME_LEN + 1];    // key of APP_ID_BY_NAME
+    uint64  FetchedNs;
+    int32   Status;
+    uint32  Result;         // AppId, or the reset subtype
+    uint32  InfoSize;
+    uint8   Info[PROXY_ES_INFO_LEN];
+} PROXY_EsEntry_t;
+
+/*
+** ES query cache, only used on the proxy task
+*/
+typedef struct
+{
+    PROXY_EsEntry_t  Entries[PROXY_ES_CACHE_SIZE > 0 ? PROXY_ES_CACHE_SIZE : 1];
+    uint32           Next;          // entry replaced when the cache is full
+    uint32           Generation;    // changes whenever the cache is emptied
+    CFE_SB_PipeId_t  EventPipe;     // ES events, which empty the cache
+    bool             PipeCreated;
+    PROXY_ShmEs_t   *Page;          // NULL until a client negotiates the feature
+    char             ShmName[PROXY_SHM_NAME_LEN];
+    uint32           Queries;
+    uint32           Hits;
+    uint32           Invalidations;
+} PROXY_Es_t;
+
+extern PROXY_Es_t PROXY_Es;
+
+void PROXY_EsInit(void);
+void PROXY_EsPoll(void);
+bool PROXY_EsMapPage(void);
+void PROXY_EsProcessCtrl(const void *Buffer, size_t Size);
+void PROXY_EsCleanup(void);
+
+#endif /* proxy_es_h */
@@ -22,5 +22,25 @@
 #define PROXY_SHUTDOWN_INF_EID          7
 #define PROXY_NNG_ERR_EID               8
 #define PROXY_UNIMPLEMENTED_ERR_EID     9
+#define PROXY_RECORD_INF_EID            10
+#define PROXY_RECORD_ERR_EID            11
+#define PROXY_TRACE_INF_EID             12
+#define PROXY_TRACE_ERR_EID             13
+#define PROXY_WAIT_INF_EID              14
+#define PROXY_LAUNCH_ERR_EID            15
+#define PROXY_CTRL_ERR_EID              16
+#define PROXY_TBL_ERR_EID               17
+#define PROXY_CDS_ERR_EID               18
+#define PROXY_POOL_ERR_EID              19
+#define PROXY_EVS_INF_EID               20
+#define PROXY_EVS_ERR_EID               21
+#define PROXY_RESTART_INF_EID           22
+#define PROXY_STATS_ERR_EID             23
+#define PROXY_HANDOVER_INF_EID          24
+#define PROXY_HANDOVER_ERR_EID          25
+#define PROXY_PERF_ERR_EID              26
+#define PROXY_USAGE_INF_EID             27
+#define PROXY_USAGE_ERR_EID             28
+#define PROXY_ES_ERR_EID                29
 
 #endif /* proxy_events_h */
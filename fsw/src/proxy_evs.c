@@ -0,0 +1,235 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * EVS filters evaluated by the client:
+ * When the client negotiates PROXY_FEATURE_EVS_FILTER, the filters of its Register call are
+ * kept in a page shared with the client rather than in EVS. The client applies the binary
+ * filter itself and only sends the events that pass, EVS sees the app registered without
+ * filters. EVS only counts the events it sends, so its counters are the same either way.
+ *
+ * The proxy is the only writer of the masks, taking the page generation as a writer lock
+ * (the Register and ResetFilter calls may run on a worker while a ground command runs on
+ * the proxy task).
+ */
+
+#include "proxy_evs.h"
+#include "proxy_ctrl.h"
+#include "proxy_events.h"
+#include "proxy_shm.h"
+#include "proxy_defs.h"
+
+
+PROXY_Evs_t PROXY_Evs;
+
+// Makes the generation odd, waiting for another writer to finish
+static void PROXY_EvsWriteBegin(void)
+{
+    uint32 gen;
+
+    do
+    {
+        gen = __atomic_load_n(&PROXY_Evs.Page->Generation, __ATOMIC_RELAXED) & ~1U;
+    } while (!__atomic_compare_exchange_n(&PROXY_Evs.Page->Generation, &gen, gen + 1, false, __ATOMIC_ACQUIRE,
+                                          __ATOMIC_RELAXED));
+}
+
+static void PROXY_EvsWriteEnd(void)
+{
+    __atomic_fetch_add(&PROXY_Evs.Page->Generation, 1, __ATOMIC_RELEASE);
+}
+
+static PROXY_EvsFilter_t *PROXY_EvsFind(uint16 EventID)
+{
+    uint32 index;
+
+    for (index = 0; index < PROXY_Evs.Page->NumFilters; index++)
+    {
+        if (PROXY_Evs.Page->Filters[index].EventID == EventID)
+        {
+            return &PROXY_Evs.Page->Filters[index];
+        }
+    }
+
+    return NULL;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_EvsMapPage                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Creates the filter page the first time the feature is negotiated.  */
+/*         Returns false (and reports) if it can not be created, the feature  */
+/*         is then not offered.                                               */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+bool PROXY_EvsMapPage(void)
+{
+    if (PROXY_Evs.Page != NULL)
+    {
+        return true;
+    }
+
+    snprintf(PROXY_Evs.ShmName, sizeof(PROXY_Evs.ShmName), "%s_evs", PROXY_SHM_PREFIX);
+
+    // The client updates the counts, so it maps the page read-write
+    PROXY_Evs.Page = PROXY_ShmCreate(PROXY_Evs.ShmName, sizeof(PROXY_ShmEvs_t), 0600, PROXY_EVS_ERR_EID);
+    if (PROXY_Evs.Page == NULL)
+    {
+        return false;
+    }
+
+    // Left by an earlier proxy perhaps, no filters until the Register call
+    memset(PROXY_Evs.Page, 0, sizeof(PROXY_ShmEvs_t));
+
+    return true;
+} /* End of PROXY_EvsMapPage() */
+
+// True when the client evaluates the filters
+bool PROXY_EvsLocal(void)
+{
+    return (PROXY_Ctrl.Features & PROXY_FEATURE_EVS_FILTER) != 0 && PROXY_Evs.Page != NULL;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_EvsRegister                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         CFE_EVS_Register for a client that filters locally: the app is     */
+/*         registered with EVS without filters and the filters go to the      */
+/*         page, with the same results CFE_EVS_Register would give.           */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+int32 PROXY_EvsRegister(const CFE_EVS_BinFilter_t *Filters, uint16 NumFilters, uint16 FilterScheme)
+{
+    int32  status;
+    uint32 index;
+
+    status = CFE_EVS_Register(NULL, 0, FilterScheme);
+    if (status != CFE_SUCCESS)
+    {
+        return status;
+    }
+
+    if (NumFilters > PROXY_EVS_MAX_FILTERS)
+    {
+        status     = CFE_EVS_APP_FILTER_OVERLOAD;
+        NumFilters = PROXY_EVS_MAX_FILTERS;
+    }
+
+    PROXY_EvsWriteBegin();
+    memset(PROXY_Evs.Page->Filters, 0, sizeof(PROXY_Evs.Page->Filters));
+    for (index = 0; index < NumFilters; index++)
+    {
+        PROXY_Evs.Page->Filters[index].EventID = Filters[index].EventID;
+        PROXY_Evs.Page->Filters[index].Mask    = Filters[index].Mask;
+    }
+    PROXY_Evs.Page->NumFilters = NumFilters;
+    PROXY_EvsWriteEnd();
+
+    return status;
+} /* End of PROXY_EvsRegister() */
+
+int32 PROXY_EvsResetFilter(uint16 EventID)
+{
+    PROXY_EvsFilter_t *Filter;
+
+    PROXY_EvsWriteBegin();
+    Filter = PROXY_EvsFind(EventID);
+    if (Filter != NULL)
+    {
+        __atomic_store_n(&Filter->Count, 0, __ATOMIC_RELAXED);
+    }
+    PROXY_EvsWriteEnd();
+
+    return Filter != NULL ? CFE_SUCCESS : CFE_EVS_EVT_NOT_REGISTERED;
+}
+
+int32 PROXY_EvsResetAllFilters(void)
+{
+    uint32 index;
+
+    PROXY_EvsWriteBegin();
+    for (index = 0; index < PROXY_Evs.Page->NumFilters; index++)
+    {
+        __atomic_store_n(&PROXY_Evs.Page->Filters[index].Count, 0, __ATOMIC_RELAXED);
+    }
+    PROXY_EvsWriteEnd();
+
+    return CFE_SUCCESS;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_EvsSetFilter                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Ground command to change the mask of a filter evaluated by the     */
+/*         client. EVS does not know these filters, so its own set filter     */
+/*         command can not reach them.                                        */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_EvsSetFilter(uint16 EventID, uint16 Mask)
+{
+    PROXY_EvsFilter_t *Filter = NULL;
+
+    if (PROXY_EvsLocal())
+    {
+        PROXY_EvsWriteBegin();
+        Filter = PROXY_EvsFind(EventID);
+        if (Filter != NULL)
+        {
+            Filter->Mask = Mask;
+        }
+        PROXY_EvsWriteEnd();
+    }
+
+    if (Filter == NULL)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_EVS_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: no client filter for event %u", (unsigned int) EventID);
+        return;
+    }
+
+    CFE_EVS_SendEventWithAppID(PROXY_EVS_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: client filter for event %u set to 0x%04X", (unsigned int) EventID,
+                               (unsigned int) Mask);
+} /* End of PROXY_EvsSetFilter() */
+
+// Answers PROXY_CTRL_EVS_MAP with the name of the page
+void PROXY_EvsProcessCtrl(const void *Buffer, size_t Size)
+{
+    PROXY_CtrlEvsReply_t Reply;
+
+    if (!PROXY_CtrlCheckLength(Buffer, Size, sizeof(PROXY_CtrlEvsMap_t)))
+    {
+        return;
+    }
+
+    memset(&Reply, 0, sizeof(Reply));
+    PROXY_CtrlInitHdr(&Reply.Hdr, PROXY_CTRL_EVS_REPLY, sizeof(Reply));
+    if (PROXY_EvsLocal())
+    {
+        Reply.Status = CFE_SUCCESS;
+        strncpy(Reply.ShmName, PROXY_Evs.ShmName, sizeof(Reply.ShmName) - 1);
+    }
+    else
+    {
+        Reply.Status = CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    send_reply(__func__, &Reply, sizeof(Reply));
+}
+
+void PROXY_EvsCleanup(void)
+{
+    if (PROXY_Evs.Page != NULL)
+    {
+        PROXY_ShmDestroy(PROXY_Evs.Page, sizeof(PROXY_ShmEvs_t), PROXY_Evs.ShmName);
+        PROXY_Evs.Page = NULL;
+    }
+}
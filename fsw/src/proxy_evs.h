@@ -0,0 +1,38 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_evs_h
+#define proxy_evs_h
+
+#include "proxy.h"
+#include "proxy_ipc.h"
+
+/*
+** EVS filter page shared with the client
+*/
+typedef struct
+{
+    PROXY_ShmEvs_t *Page;       // NULL until the feature is negotiated
+    char            ShmName[PROXY_SHM_NAME_LEN];
+} PROXY_Evs_t;
+
+extern PROXY_Evs_t PROXY_Evs;
+
+bool  PROXY_EvsMapPage(void);
+bool  PROXY_EvsLocal(void);
+int32 PROXY_EvsRegister(const CFE_EVS_BinFilter_t *Filters, uint16 NumFilters, uint16 FilterScheme);
+int32 PROXY_EvsResetFilter(uint16 EventID);
+int32 PROXY_EvsResetAllFilters(void);
+void  PROXY_EvsSetFilter(uint16 EventID, uint16 Mask);
+void  PROXY_EvsProcessCtrl(const void *Buffer, size_t Size);
+void  PROXY_EvsCleanup(void);
+
+#endif /* proxy_evs_h */
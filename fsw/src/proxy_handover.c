@@ -0,0 +1,310 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Hot handover (PROXY_HANDOVER_CC):
+ * 1. A replacement app is launched with PROXY_IPC_ADDRESS set to the endpoint that is not in
+ *    use, and a standby socket listens there. The old app is serviced as usual meanwhile, and
+ *    so is the replacement while it initializes (HELLO, tables, CDS, EVS registration) on
+ *    the standby socket.
+ * 2. PROXY_CTRL_READY, or the first RunLoop of a client that does not send it, is the
+ *    readiness handshake. The proxy task swaps the sockets between two receives, so the old
+ *    app is never serviced as the actual app after that.
+ * 3. The old app is retired on the standby socket: its outstanding calls are still answered
+ *    and its next RunLoop returns false, so it exits the way a cFS app is told to. It is
+ *    killed if it has not exited after PROXY_HANDOVER_RETIRE_MS.
+ *
+ * The EVS registration belongs to the proxy app, so it survives. The Register call of the
+ * replacement is answered without touching EVS or the client filter page, which keeps the
+ * masks (including any set from the ground) and the counts. The HELLO of the replacement
+ * negotiates its features apart from the old app, which keeps its own until the switch and
+ * after an abort; a replacement that sends no HELLO gets no features.
+ */
+
+#include "proxy_handover.h"
+#include "proxy_ctrl.h"
+#include "proxy_launch.h"
+#include "proxy_events.h"
+#include "proxy_defs.h"
+
+#include <signal.h>
+#include <sys/wait.h>
+
+// Flat Buff Stuff
+#include <cfs_api_builder.h>
+#undef ns
+#define ns(x) FLATBUFFERS_WRAP_NAMESPACE(cFS_API, x)
+
+PROXY_Handover_t PROXY_Handover;
+
+// The two endpoints the actual app alternates between
+static const char *const PROXY_HandoverAddresses[2] = { IPC_PIPE_ADDRESS, PROXY_HANDOVER_ADDRESS };
+
+// Kills what is left on the standby socket and closes it
+static void PROXY_HandoverRelease(void)
+{
+    if (PROXY_Handover.Pid > 0)
+    {
+        kill(PROXY_Handover.Pid, SIGKILL);
+        waitpid(PROXY_Handover.Pid, NULL, 0);
+    }
+    PROXY_Handover.Pid = -1;
+
+    __atomic_store_n(&PROXY_Handover.KeepRegistration, false, __ATOMIC_RELEASE);
+
+    // Replies still queued for the standby socket fail with NNG_ECLOSED and are freed
+    nng_close(PROXY_Handover.Standby);
+    PROXY_Handover.State = PROXY_HANDOVER_IDLE;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_HandoverStart                                                */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Ground command: listens on the standby endpoint and launches the   */
+/*         replacement app. The switch happens in PROXY_HandoverPoll.         */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_HandoverStart(void)
+{
+    PROXY_LaunchAttr_t Attr    = PROXY_LaunchAttr;
+    const char        *Address = PROXY_HandoverAddresses[PROXY_Handover.Active ^ 1];
+    const char        *nng_call;
+    int                rv;
+
+    if (PROXY_Handover.State != PROXY_HANDOVER_IDLE)
+    {
+        PROXY_HkTelemetryPkt.proxy_command_error_count++;
+        CFE_EVS_SendEventWithAppID(PROXY_HANDOVER_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: handover already in progress, state %u",
+                                   (unsigned int) PROXY_Handover.State);
+        return;
+    }
+
+    PROXY_HkTelemetryPkt.proxy_command_count++;
+
+    rv = PROXY_OpenSocket(&PROXY_Handover.Standby, Address, &nng_call);
+    if (rv != 0)
+    {
+        nng_close(PROXY_Handover.Standby);
+        PROXY_Handover.Failures++;
+        CFE_EVS_SendEventWithAppID(PROXY_HANDOVER_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: handover on %s failed, %s error: %s", Address, nng_call,
+                                   nng_strerror(rv));
+        return;
+    }
+
+    Attr.IpcAddress    = Address;
+    PROXY_Handover.Pid = PROXY_LaunchChild(&Attr);
+    if (PROXY_Handover.Pid < 0)
+    {
+        PROXY_LaunchReportError();
+        PROXY_Handover.Failures++;
+        nng_close(PROXY_Handover.Standby);
+        return;
+    }
+
+    PROXY_Handover.State      = PROXY_HANDOVER_STARTING;
+    PROXY_Handover.DeadlineNs = PROXY_MonotonicNs() + (uint64) PROXY_HANDOVER_READY_MS * 1000000;
+    PROXY_CtrlReset(&PROXY_Handover.Ctrl);
+
+    // The replacement registers with EVS while it initializes
+    __atomic_store_n(&PROXY_Handover.KeepRegistration, PROXY_HkTelemetryPkt.actual_registered != 0,
+                     __ATOMIC_RELEASE);
+
+    CFE_EVS_SendEventWithAppID(PROXY_HANDOVER_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: handover started, replacement pid %d on %s", (int) PROXY_Handover.Pid,
+                               Address);
+} /* End of PROXY_HandoverStart() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_HandoverSwitch                                               */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Makes the replacement the actual app and services its readiness    */
+/*         message. Runs on the proxy task between two receives, so no call   */
+/*         is serviced half on one socket and half on the other.              */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+static void PROXY_HandoverSwitch(char *Buffer, size_t Size)
+{
+    nng_socket OldSock = sock;
+    pid_t      OldPid  = childPID;
+
+    sock     = PROXY_Handover.Standby;
+    childPID = PROXY_Handover.Pid;
+
+    PROXY_Handover.Standby = OldSock;
+    PROXY_Handover.Pid     = OldPid;
+    PROXY_Handover.Active ^= 1;
+
+    // A later restart launches the app on the endpoint now in use
+    PROXY_LaunchAttr.IpcAddress = PROXY_HandoverAddresses[PROXY_Handover.Active];
+
+    // The replacement keeps what it negotiated, nothing if it sent no HELLO of its own
+    PROXY_Ctrl = PROXY_Handover.Ctrl;
+
+    PROXY_Handover.State      = PROXY_HANDOVER_RETIRING;
+    PROXY_Handover.DeadlineNs = PROXY_MonotonicNs() + (uint64) PROXY_HANDOVER_RETIRE_MS * 1000000;
+    PROXY_Handover.Count++;
+
+    CFE_EVS_SendEventWithAppID(PROXY_HANDOVER_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: switched to pid %d, retiring pid %d", (int) childPID, (int) OldPid);
+
+    process_message(Buffer, Size);
+} /* End of PROXY_HandoverSwitch() */
+
+// The message that tells the replacement is done initializing
+static bool PROXY_HandoverIsReady(const char *Buffer, size_t Size)
+{
+    if (PROXY_IsCtrlFrame(Buffer, Size))
+    {
+        return ((const PROXY_CtrlHdr_t *) Buffer)->Type == PROXY_CTRL_READY;
+    }
+
+    return ns(RemoteCall_input_type(ns(RemoteCall_as_root(Buffer)))) == ns(Function_RunLoop);
+}
+
+// STARTING: services the replacement until it is ready, gives up if it never is
+static void PROXY_HandoverWaitReady(void)
+{
+    char  *buffer = NULL;
+    size_t sz;
+    uint16 msgs = 0;
+    int    rv   = 0;
+
+    while (msgs < PROXY_SLICE_MSG_BUDGET &&
+           (rv = nng_recv(PROXY_Handover.Standby, &buffer, &sz, NNG_FLAG_ALLOC | NNG_FLAG_NONBLOCK)) == 0)
+    {
+        if (PROXY_HandoverIsReady(buffer, sz))
+        {
+            PROXY_HandoverSwitch(buffer, sz);
+            return;
+        }
+        process_message_from(PROXY_Handover.Standby, buffer, sz);
+        msgs++;
+    }
+
+    if (rv != 0 && rv != NNG_EAGAIN)
+    {
+        PROXY_HkTelemetryPkt.proxy_nng_error = rv;
+        PROXY_HandoverAbort(nng_strerror(rv));
+    }
+    else if (waitpid(PROXY_Handover.Pid, NULL, WNOHANG) == PROXY_Handover.Pid)
+    {
+        PROXY_Handover.Pid = -1;
+        PROXY_HandoverAbort("replacement exited");
+    }
+    else if (PROXY_MonotonicNs() > PROXY_Handover.DeadlineNs)
+    {
+        PROXY_HandoverAbort("replacement not ready in time");
+    }
+}
+
+// RETIRING: answers what the old app still sends until it exits or runs out of time
+static void PROXY_HandoverRetire(void)
+{
+    char  *buffer = NULL;
+    size_t sz;
+    uint16 msgs = 0;
+    bool   killed = false;
+
+    while (msgs < PROXY_SLICE_MSG_BUDGET &&
+           nng_recv(PROXY_Handover.Standby, &buffer, &sz, NNG_FLAG_ALLOC | NNG_FLAG_NONBLOCK) == 0)
+    {
+        process_message_from(PROXY_Handover.Standby, buffer, sz);
+        msgs++;
+    }
+
+    if (PROXY_Handover.Pid > 0 && waitpid(PROXY_Handover.Pid, NULL, WNOHANG) == 0)
+    {
+        if (PROXY_MonotonicNs() < PROXY_Handover.DeadlineNs)
+        {
+            return;
+        }
+        killed = true;
+    }
+    else
+    {
+        PROXY_Handover.Pid = -1;
+    }
+
+    PROXY_HandoverRelease();
+
+    CFE_EVS_SendEventWithAppID(PROXY_HANDOVER_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: handover to pid %d complete, old app %s", (int) childPID,
+                               killed ? "killed" : "exited");
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_HandoverPoll                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Advances a handover in progress, called once per pass of the run   */
+/*         loop on the proxy task. Never blocks.                              */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_HandoverPoll(void)
+{
+    switch (PROXY_Handover.State)
+    {
+        case PROXY_HANDOVER_STARTING:
+            PROXY_HandoverWaitReady();
+            break;
+
+        case PROXY_HANDOVER_RETIRING:
+            PROXY_HandoverRetire();
+            break;
+
+        default:
+            break;
+    }
+} /* End of PROXY_HandoverPoll() */
+
+// Ends a handover in progress. The old app keeps running if the replacement was not ready.
+void PROXY_HandoverAbort(const char *Reason)
+{
+    if (PROXY_Handover.State == PROXY_HANDOVER_STARTING)
+    {
+        PROXY_Handover.Failures++;
+        CFE_EVS_SendEventWithAppID(PROXY_HANDOVER_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: handover aborted: %s", Reason);
+    }
+
+    if (PROXY_Handover.State != PROXY_HANDOVER_IDLE)
+    {
+        PROXY_HandoverRelease();
+    }
+}
+
+// True for calls from the replacement that is starting or the old app that is retiring
+bool PROXY_HandoverStandby(nng_socket Sock)
+{
+    return PROXY_Handover.State != PROXY_HANDOVER_IDLE &&
+           nng_socket_id(Sock) == nng_socket_id(PROXY_Handover.Standby);
+}
+
+// Index of the endpoint Sock listens on, for resources kept per endpoint
+uint8 PROXY_HandoverEndpoint(nng_socket Sock)
+{
+    return PROXY_HandoverStandby(Sock) ? (PROXY_Handover.Active ^ 1) : PROXY_Handover.Active;
+}
+
+// True once after a switch, for the Register call of the replacement (may run on a worker)
+bool PROXY_HandoverKeepRegistration(void)
+{
+    return __atomic_exchange_n(&PROXY_Handover.KeepRegistration, false, __ATOMIC_ACQ_REL);
+}
+
+void PROXY_HandoverCleanup(void)
+{
+    if (PROXY_Handover.State != PROXY_HANDOVER_IDLE)
+    {
+        PROXY_HandoverRelease();
+    }
+}
@@ -0,0 +1,54 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_handover_h
+#define proxy_handover_h
+
+#include "proxy.h"
+#include "proxy_ctrl.h"
+
+/* Handover states (PROXY_HANDOVER_CC) */
+#define PROXY_HANDOVER_IDLE       0
+#define PROXY_HANDOVER_STARTING   1   /* replacement launched, initializing on the standby socket */
+#define PROXY_HANDOVER_RETIRING   2   /* switched over, the old app finishes its calls and exits */
+
+/*
+** Hot handover to a replacement actual app
+**
+** The replacement dials the endpoint that is not in use (IPC_PIPE_ADDRESS and
+** PROXY_HANDOVER_ADDRESS alternate) and initializes on the standby socket while the old app
+** is still the actual app. When it is ready the sockets are swapped and the old app is
+** retired on the standby socket.
+*/
+typedef struct
+{
+    uint8       State;
+    uint8       Active;           // index of the endpoint of the active socket
+    bool        KeepRegistration; // the Register call of the replacement is carried over from the old app
+    PROXY_Ctrl_t Ctrl;            // STARTING: negotiated by the replacement, the actual app's on switch
+    nng_socket  Standby;          // STARTING: the replacement, RETIRING: the old app
+    pid_t       Pid;              // process on the standby socket, -1 if it is gone
+    uint64      DeadlineNs;       // for the replacement to be ready, or the old app to exit
+    uint32      Count;            // completed handovers
+    uint32      Failures;         // replacements that never became ready
+} PROXY_Handover_t;
+
+extern PROXY_Handover_t PROXY_Handover;
+
+void PROXY_HandoverStart(void);
+void PROXY_HandoverPoll(void);
+void PROXY_HandoverAbort(const char *Reason);
+bool PROXY_HandoverStandby(nng_socket Sock);
+uint8 PROXY_HandoverEndpoint(nng_socket Sock);
+bool PROXY_HandoverKeepRegistration(void);
+void PROXY_HandoverCleanup(void);
+
+#endif /* proxy_handover_h */
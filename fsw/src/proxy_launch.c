@@ -0,0 +1,316 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Launching the actual app:
+ * The child applies its launch attributes and then execs. It can not send events, so any
+ * failure is written as a PROXY_LaunchError_t to a close-on-exec pipe. The parent reads the
+ * pipe: end of file means the exec succeeded, anything else is reported as an event.
+ *
+ * mlockall does not survive exec, so MlockAll lifts RLIMIT_MEMLOCK and sets PROXY_MLOCKALL=1
+ * in the environment of the app, which is expected to call mlockall itself at startup.
+ *
+ * The proxy has other threads by the time it forks, so the child only makes async-signal-safe
+ * calls: the environment of the app is built before the fork and handed to execvpe.
+ */
+
+#define _GNU_SOURCE
+
+#include "proxy_launch.h"
+#include "proxy_events.h"
+#include "proxy_defs.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// Room for the PROXY_IPC_ADDRESS entry of the environment
+#define PROXY_LAUNCH_VAR_LEN 128
+
+typedef struct
+{
+    int32 Stage;
+    int32 Errno;
+} PROXY_LaunchError_t;
+
+PROXY_LaunchAttr_t PROXY_LaunchAttr =
+    {
+        .CpuMask       = PROXY_CHILD_CPU_MASK,
+        .SchedPolicy   = PROXY_CHILD_SCHED_POLICY,
+        .SchedPriority = PROXY_CHILD_SCHED_PRIORITY,
+        .Nice          = PROXY_CHILD_NICE,
+        .MlockAll      = PROXY_CHILD_MLOCKALL,
+        .MemLimit      = PROXY_CHILD_MEM_LIMIT,
+        .IpcAddress    = IPC_PIPE_ADDRESS,
+    };
+
+static const char *PROXY_LaunchStageName(int32 Stage)
+{
+    switch (Stage)
+    {
+        case PROXY_LAUNCH_FORK:     return "fork";
+        case PROXY_LAUNCH_AFFINITY: return "sched_setaffinity";
+        case PROXY_LAUNCH_SCHED:    return "sched_setscheduler";
+        case PROXY_LAUNCH_NICE:     return "setpriority";
+        case PROXY_LAUNCH_MEMLOCK:  return "RLIMIT_MEMLOCK";
+        case PROXY_LAUNCH_RLIMIT:   return "RLIMIT_AS";
+        case PROXY_LAUNCH_EXEC:     return "exec";
+        case PROXY_LAUNCH_PIPE:     return "pipe";
+        case PROXY_LAUNCH_ENV:      return "environment";
+        default:                    return "unknown";
+    }
+}
+
+// Runs in the child: report the failed stage to the parent and exit
+static void PROXY_LaunchFail(int Fd, int32 Stage)
+{
+    PROXY_LaunchError_t Error = { Stage, errno };
+
+    if (write(Fd, &Error, sizeof(Error)) < 0)
+    {
+        // Nothing more can be done, the parent sees a failed launch without a stage
+    }
+    _exit(127);
+}
+
+// Runs in the child: apply the attributes, returns the failed stage or PROXY_LAUNCH_OK
+static int32 PROXY_LaunchApply(const PROXY_LaunchAttr_t *Attr)
+{
+    struct sched_param param;
+    struct rlimit      limit;
+    cpu_set_t          cpus;
+    int                cpu;
+
+    if (Attr->CpuMask != 0)
+    {
+        CPU_ZERO(&cpus);
+        for (cpu = 0; cpu < 32; cpu++)
+        {
+            if (Attr->CpuMask & (1U << cpu))
+            {
+                CPU_SET(cpu, &cpus);
+            }
+        }
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+        {
+            return PROXY_LAUNCH_AFFINITY;
+        }
+    }
+
+    if (Attr->SchedPolicy != PROXY_LAUNCH_INHERIT)
+    {
+        memset(&param, 0, sizeof(param));
+        if (Attr->SchedPolicy == SCHED_FIFO)
+        {
+            param.sched_priority = Attr->SchedPriority;
+        }
+        if (sched_setscheduler(0, Attr->SchedPolicy, &param) != 0)
+        {
+            return PROXY_LAUNCH_SCHED;
+        }
+    }
+
+    if (Attr->Nice != PROXY_LAUNCH_INHERIT && Attr->SchedPolicy != SCHED_FIFO)
+    {
+        if (setpriority(PRIO_PROCESS, 0, Attr->Nice) != 0)
+        {
+            return PROXY_LAUNCH_NICE;
+        }
+    }
+
+    if (Attr->MlockAll)
+    {
+        limit.rlim_cur = RLIM_INFINITY;
+        limit.rlim_max = RLIM_INFINITY;
+        if (setrlimit(RLIMIT_MEMLOCK, &limit) != 0)
+        {
+            return PROXY_LAUNCH_MEMLOCK;
+        }
+    }
+
+    if (Attr->MemLimit != 0)
+    {
+        limit.rlim_cur = Attr->MemLimit;
+        limit.rlim_max = Attr->MemLimit;
+        if (setrlimit(RLIMIT_AS, &limit) != 0)
+        {
+            return PROXY_LAUNCH_RLIMIT;
+        }
+    }
+
+    return PROXY_LAUNCH_OK;
+}
+
+// True if the environment entry sets one of the variables the proxy gives the app
+static bool PROXY_LaunchOwnVar(const char *Entry)
+{
+    return strncmp(Entry, "PROXY_MLOCKALL=", 15) == 0 || strncmp(Entry, "PROXY_IPC_ADDRESS=", 18) == 0;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_LaunchEnv                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Builds the environment of the app in the parent: the environment   */
+/*         of the proxy with PROXY_MLOCKALL and PROXY_IPC_ADDRESS set from    */
+/*         the attributes. IpcVar holds the PROXY_IPC_ADDRESS entry. Returns  */
+/*         NULL if it can not be allocated, free it after the fork.           */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+static char **PROXY_LaunchEnv(const PROXY_LaunchAttr_t *Attr, char *IpcVar, size_t IpcVarSize)
+{
+    static char MlockVar[] = "PROXY_MLOCKALL=1";
+    char      **envp;
+    size_t      count = 0;
+    size_t      index;
+
+    while (environ[count] != NULL)
+    {
+        count++;
+    }
+
+    envp = malloc((count + 3) * sizeof(*envp));
+    if (envp == NULL)
+    {
+        return NULL;
+    }
+
+    count = 0;
+    for (index = 0; environ[index] != NULL; index++)
+    {
+        if (!PROXY_LaunchOwnVar(environ[index]))
+        {
+            envp[count++] = environ[index];
+        }
+    }
+
+    if (Attr->MlockAll)
+    {
+        envp[count++] = MlockVar;
+    }
+
+    // Both endpoints are in use during a handover, the app can not assume IPC_PIPE_ADDRESS
+    if (Attr->IpcAddress != NULL)
+    {
+        snprintf(IpcVar, IpcVarSize, "PROXY_IPC_ADDRESS=%s", Attr->IpcAddress);
+        envp[count++] = IpcVar;
+    }
+    envp[count] = NULL;
+
+    return envp;
+} /* End of PROXY_LaunchEnv() */
+
+// Records a launch failure in housekeeping, PROXY_LaunchReportError sends the event
+static void PROXY_LaunchReport(int32 Stage, int32 Errno)
+{
+    PROXY_HkTelemetryPkt.proxy_fork_error   = Errno;
+    PROXY_HkTelemetryPkt.proxy_launch_stage = Stage;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_LaunchReportError                                            */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Sends the event for a failed PROXY_LaunchChild. This is separate   */
+/*         because at init the app is launched before PEVS can be used.       */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_LaunchReportError(void)
+{
+    if (PROXY_HkTelemetryPkt.proxy_launch_stage != PROXY_LAUNCH_OK)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_LAUNCH_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: launch of %s failed in %s: %s", EXEC_INSTRUCTION,
+                                   PROXY_LaunchStageName(PROXY_HkTelemetryPkt.proxy_launch_stage),
+                                   strerror(PROXY_HkTelemetryPkt.proxy_fork_error));
+    }
+} /* End of PROXY_LaunchReportError() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_LaunchChild                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Fork / exec the actual app with the given attributes. Returns the  */
+/*         child PID, or -1 if the launch failed (see PROXY_LaunchReportError)*/
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+pid_t PROXY_LaunchChild(const PROXY_LaunchAttr_t *Attr)
+{
+    static char *const argv[] = { EXEC_ARGUMENTS, NULL };
+    PROXY_LaunchError_t Error;
+    char    IpcVar[PROXY_LAUNCH_VAR_LEN];
+    char  **envp;
+    int     report[2];
+    int32   Stage;
+    ssize_t got;
+    pid_t   pid;
+
+    envp = PROXY_LaunchEnv(Attr, IpcVar, sizeof(IpcVar));
+    if (envp == NULL)
+    {
+        PROXY_LaunchReport(PROXY_LAUNCH_ENV, errno);
+        return -1;
+    }
+
+    if (pipe2(report, O_CLOEXEC) != 0)
+    {
+        PROXY_LaunchReport(PROXY_LAUNCH_PIPE, errno);
+        free(envp);
+        return -1;
+    }
+
+    pid = fork();
+    if (pid == 0)
+    { // Child process
+        close(report[0]);
+
+        Stage = PROXY_LaunchApply(Attr);
+        if (Stage != PROXY_LAUNCH_OK)
+        {
+            PROXY_LaunchFail(report[1], Stage);
+        }
+
+        execvpe(EXEC_INSTRUCTION, argv, envp);
+        PROXY_LaunchFail(report[1], PROXY_LAUNCH_EXEC);
+    }
+
+    free(envp);
+    close(report[1]);
+    if (pid < 0)
+    {
+        close(report[0]);
+        PROXY_LaunchReport(PROXY_LAUNCH_FORK, errno);
+        return -1;
+    }
+
+    // Blocks only until the exec (or the failure), not for the app itself
+    do
+    {
+        got = read(report[0], &Error, sizeof(Error));
+    } while (got < 0 && errno == EINTR);
+    close(report[0]);
+
+    if (got != 0)
+    {
+        if (got != sizeof(Error))
+        {
+            Error.Stage = PROXY_LAUNCH_PIPE;
+            Error.Errno = (got < 0) ? errno : EIO;
+        }
+        waitpid(pid, NULL, 0);
+        PROXY_LaunchReport(Error.Stage, Error.Errno);
+        return -1;
+    }
+
+    PROXY_HkTelemetryPkt.proxy_fork_error   = 0;
+    PROXY_HkTelemetryPkt.proxy_launch_stage = PROXY_LAUNCH_OK;
+
+    return pid;
+} /* End of PROXY_LaunchChild() */
@@ -0,0 +1,51 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_launch_h
+#define proxy_launch_h
+
+#include "proxy.h"
+
+// Leave the attribute as inherited from the cFS task
+#define PROXY_LAUNCH_INHERIT     (-1000)
+
+/* Launch stages, reported in PROXY_LAUNCH_ERR_EID and housekeeping */
+#define PROXY_LAUNCH_OK          0
+#define PROXY_LAUNCH_FORK        1
+#define PROXY_LAUNCH_AFFINITY    2
+#define PROXY_LAUNCH_SCHED       3
+#define PROXY_LAUNCH_NICE        4
+#define PROXY_LAUNCH_MEMLOCK     5
+#define PROXY_LAUNCH_RLIMIT      6
+#define PROXY_LAUNCH_EXEC        7
+#define PROXY_LAUNCH_PIPE        8
+#define PROXY_LAUNCH_ENV         9
+
+/*
+** Attributes applied to the actual app between fork and exec
+*/
+typedef struct
+{
+    uint32  CpuMask;        // Bit n allows CPU n, 0 to inherit
+    int32   SchedPolicy;    // SCHED_OTHER, SCHED_FIFO or PROXY_LAUNCH_INHERIT
+    int32   SchedPriority;  // Priority for SCHED_FIFO
+    int32   Nice;           // Nice value for SCHED_OTHER, or PROXY_LAUNCH_INHERIT
+    bool    MlockAll;       // Lift RLIMIT_MEMLOCK and ask the app to mlockall (see proxy_launch.c)
+    uint64  MemLimit;       // RLIMIT_AS in bytes, 0 to inherit
+    const char *IpcAddress; // Endpoint to dial, set in PROXY_IPC_ADDRESS for the app
+} PROXY_LaunchAttr_t;
+
+extern PROXY_LaunchAttr_t PROXY_LaunchAttr;
+
+pid_t PROXY_LaunchChild(const PROXY_LaunchAttr_t *Attr);
+void  PROXY_LaunchReportError(void);
+
+#endif /* proxy_launch_h */
@@ -17,6 +17,21 @@
 */
 #define PROXY_NOOP_CC                 0
 #define PROXY_RESET_COUNTERS_CC       1
+#define PROXY_RECORD_START_CC         2
+#define PROXY_RECORD_STOP_CC          3
+#define PROXY_TRACE_ENABLE_CC         4
+#define PROXY_TRACE_DUMP_CC           5
+#define PROXY_SET_WAIT_STRATEGY_CC    6
+#define PROXY_SET_EVS_FILTER_CC       7
+#define PROXY_HANDOVER_CC             8
+#define PROXY_SET_USAGE_LIMITS_CC     9
+
+/*
+** Wait strategies (PROXY_SET_WAIT_STRATEGY_CC)
+*/
+#define PROXY_WAIT_BLOCKING           0
+#define PROXY_WAIT_BUSY_POLL          1
+#define PROXY_WAIT_HYBRID             2
 
 /*************************************************************************/
 /*
@@ -28,6 +43,61 @@ typedef struct
 
 } PROXY_NoArgsCmd_t;
 
+/*
+** Type definition (command with a file name, empty for the default)
+*/
+typedef struct
+{
+   uint8    CmdHeader[sizeof(CFE_MSG_CommandHeader_t)];
+   char     Filename[OS_MAX_PATH_LEN];
+
+} PROXY_FilenameCmd_t;
+
+/*
+** Type definition (enable / disable command)
+*/
+typedef struct
+{
+   uint8    CmdHeader[sizeof(CFE_MSG_CommandHeader_t)];
+   uint8    Enable;
+   uint8    Spare[3];
+
+} PROXY_EnableCmd_t;
+
+/*
+** Type definition (set wait strategy)
+*/
+typedef struct
+{
+   uint8    CmdHeader[sizeof(CFE_MSG_CommandHeader_t)];
+   uint8    Strategy;       // PROXY_WAIT_*
+   uint8    Spare[3];
+   uint32   SpinMaxUs;      // Upper bound of the hybrid spin, 0 to keep the current one
+
+} PROXY_WaitStrategyCmd_t;
+
+/*
+** Type definition (set the mask of an EVS filter evaluated by the actual app)
+*/
+typedef struct
+{
+   uint8    CmdHeader[sizeof(CFE_MSG_CommandHeader_t)];
+   uint16   EventID;
+   uint16   Mask;           // CFE_EVS_*_FILTER
+
+} PROXY_EvsFilterCmd_t;
+
+/*
+** Type definition (limits on the resources used by the actual app, 0 for none)
+*/
+typedef struct
+{
+   uint8    CmdHeader[sizeof(CFE_MSG_CommandHeader_t)];
+   uint32   CpuPctMax;      // percent of one CPU
+   uint32   RssKbMax;       // resident memory in KiB
+
+} PROXY_UsageLimitsCmd_t;
+
 // TODO: Command to send HK? How does the proxy recieve commands to start with?
 
 /*************************************************************************/
@@ -42,7 +112,7 @@ typedef struct
 
     // Data about the proxy
     int32              proxy_pevs_access;    // retrun code from CFE_ES_GetAppIDByName
-    int32              proxy_fork_error;     // errno after failed fork()
+    int32              proxy_fork_error;     // errno after failed launch of the actual app
     int32              proxy_nng_error;      // return code from nng library call
 
     // Data about the actual application
@@ -51,6 +121,105 @@ typedef struct
     uint32             actual_func_calls;
     uint32             actual_reset_count;
     uint32             actual_ms_last_msg;
+
+    // Fields below are appended to the baseline packet, the ones above keep their offsets
+    int32              proxy_launch_stage;   // stage of the failed launch of the actual app, 0 if none
+
+    // Data about the scheduled slices (PROXY_SCHEDULED_MODE)
+    uint32             slice_count;          // wakeups serviced
+    uint32             slice_overruns;       // slices that ran out of message or time budget
+    uint16             slice_last_msgs;      // remote calls serviced in the last slice
+    uint16             slice_max_msgs;
+    uint32             slice_last_us;        // duration of the last slice
+    uint32             slice_max_us;
+
+    // Record mode
+    uint8              record_state;
+    uint8              record_spare[3];
+    uint32             record_frames;
+    uint32             record_drops;
+
+    // RPC trace
+    uint8              trace_enabled;
+    uint8              trace_spare[3];
+    uint32             trace_calls;          // calls traced since boot, the ring keeps the last PROXY_TRACE_DEPTH
+
+    // Wait strategy, cleared when the strategy changes
+    uint8              wait_strategy;
+    uint8              wait_spare[3];
+    uint32             wait_spin_budget_us;  // current adaptive spin time (hybrid)
+    uint32             wait_spin_hits;       // messages found while polling
+    uint32             wait_block_hits;      // messages that woke a blocking wait
+    uint32             wait_timeouts;
+    uint32             wait_idle_wall_ms;    // time spent waiting
+    uint32             wait_idle_cpu_ms;     // proxy CPU time used while waiting
+    uint32             wait_poll_gap_max_us; // worst case wakeup latency of a polled message
+
+    // Startup phases, us after PROXY_Init started (0 if not reached yet)
+    uint32             startup_listen_us;
+    uint32             startup_launch_us;        // fork / exec of the actual app done
+    uint32             startup_sync_us;          // CFE_ES_WaitForStartupSync returned
+    uint32             startup_connect_us;       // first connection from the actual app
+    uint32             startup_ready_us;         // actual app sent its ready message
+    uint32             startup_first_runloop_us;
+    uint32             actual_connects;
+
+    // Protocol negotiated with the client (HELLO / CAPABILITIES)
+    uint16             ctrl_protocol_version;    // of the client, 0 if it never sent HELLO
+    uint16             ctrl_spare;
+    uint32             ctrl_features;
+    uint32             ctrl_max_message_size;
+
+    uint32             tbl_count;                // tables registered for the actual app
+    uint32             tbl_refreshes;            // images copied to shared memory
+
+    uint32             cds_count;                // CDS blocks registered for the actual app
+    uint32             cds_flushes;              // mirrors committed to the CDS
+    uint32             cds_restores;             // mirrors restored from the CDS
+
+    uint32             pool_size;                // worker tasks, 0 when calls are serviced inline
+    uint32             pool_jobs;                // messages handed to the workers
+    uint32             pool_queue_depth;         // messages queued or in service
+    uint32             pool_queue_depth_max;
+    uint32             pool_queue_full;          // waits for room in a worker queue
+    uint32             pool_inline_waits;        // inline calls that waited for their worker
+    uint32             pool_wait_last_us;        // time the last message spent queued
+    uint32             pool_wait_max_us;
+
+    uint8              evs_filter_local;         // EVS filters evaluated by the actual app
+    uint8              evs_filter_count;
+    uint16             evs_filter_spare;
+    uint32             evs_filter_generation;    // changes with every filter update
+
+    uint32             out_queued_bytes;         // replies waiting for the actual app
+    uint32             out_high_water_bytes;
+    uint32             out_queued;               // replies that had to be queued
+    uint32             out_drops;                // replies dropped, the queue was full
+    int32              out_error;                // last failed queued send
+
+    // Hot handover (PROXY_HANDOVER_CC)
+    uint8              handover_state;           // PROXY_HANDOVER_* (proxy_handover.h)
+    uint8              handover_spare[3];
+    uint32             handover_count;           // completed handovers
+    uint32             handover_failures;        // replacements that never became ready
+
+    // Perf markers from the shared ring (PROXY_FEATURE_PERF_RING)
+    uint32             perf_markers;             // drained from the ring
+    uint32             perf_dropped;             // lost in the actual app, the ring was full
+
+    // Resources used by the actual app, sampled every PROXY_USAGE_PERIOD_MS
+    uint32             child_cpu_pct;            // percent of one CPU over the last period
+    uint32             child_utime_ms;           // user CPU time
+    uint32             child_stime_ms;           // system CPU time
+    uint32             child_rss_kb;             // resident memory
+    uint32             child_min_faults;         // page faults without I/O
+    uint32             child_maj_faults;         // page faults with I/O
+    uint32             child_vol_ctx_switches;   // the app blocked
+    uint32             child_invol_ctx_switches; // the app was preempted
+    uint32             child_usage_alarms;       // limits exceeded
+    uint32             es_queries;               // ES queries from the actual app
+    uint32             es_cache_hits;            // answered from the cache
+    uint32             es_cache_invalidations;   // cache emptied on an ES event
 }   __attribute__((packed)) proxy_hk_tlm_t  ;
 
 #define PROXY_HK_TLM_LNGTH   sizeof ( proxy_hk_tlm_t )
@@ -0,0 +1,233 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Outbound queue:
+ * Replies are first offered to the socket without blocking. When the actual app is not
+ * reading, they are copied into a bounded queue that an aio drains in the background, in
+ * order. The queue is bounded by PROXY_OUT_QUEUE_DEPTH messages and PROXY_OUT_QUEUE_BYTES,
+ * what does not fit is handled by PROXY_OUT_OVERFLOW_POLICY.
+ *
+ * The queue is shared by the proxy task, the workers and the aio callback (an nng thread),
+ * so it is protected by an nng mutex rather than an OSAL one.
+ */
+
+#include "proxy_out.h"
+#include "proxy_events.h"
+
+PROXY_Out_t PROXY_Out;
+
+static void PROXY_OutSendDone(void *Arg);
+
+// Hands the head of the queue to the aio, called with the mutex held
+static void PROXY_OutStartHead(void)
+{
+    PROXY_OutEntry_t *Entry = &PROXY_Out.Queue[PROXY_Out.Head];
+
+    PROXY_Out.Busy = true;
+    nng_aio_set_msg(PROXY_Out.Aio, Entry->Msg);
+    nng_send_aio(Entry->Sock, PROXY_Out.Aio);
+}
+
+// Removes the head of the queue, called with the mutex held
+static void PROXY_OutPopHead(void)
+{
+    PROXY_Out.Bytes -= PROXY_Out.Queue[PROXY_Out.Head].Length;
+    PROXY_Out.Head   = (PROXY_Out.Head + 1) % PROXY_OUT_QUEUE_DEPTH;
+    PROXY_Out.Count--;
+}
+
+int PROXY_OutInit(void)
+{
+    int rv;
+
+    rv = nng_mtx_alloc(&PROXY_Out.Mutex);
+    if (rv == 0)
+    {
+        rv = nng_aio_alloc(&PROXY_Out.Aio, PROXY_OutSendDone, NULL);
+    }
+
+    return rv;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_OutSend                                                      */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Sends a reply without blocking: directly if nothing is queued and  */
+/*         the socket takes it, through the queue otherwise. Returns the nng  */
+/*         error of a failed send, a queued or dropped reply returns 0 (drops */
+/*         are counted and handled by the overflow policy).                   */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+int PROXY_OutSend(nng_socket Sock, const void *Data, size_t Length)
+{
+    PROXY_OutEntry_t *Entry;
+    nng_msg          *msg;
+    int               rv = 0;
+
+    if (PROXY_Out.Aio == NULL)
+    {
+        // PROXY_OutInit failed, fall back to a blocking send
+        return nng_send(Sock, (void *) Data, Length, 0);
+    }
+
+    nng_mtx_lock(PROXY_Out.Mutex);
+
+    if (PROXY_Out.Count == 0)
+    {
+        // Nothing to keep in order with, the common case does not copy the reply
+        rv = nng_send(Sock, (void *) Data, Length, NNG_FLAG_NONBLOCK);
+        if (rv != NNG_EAGAIN)
+        {
+            nng_mtx_unlock(PROXY_Out.Mutex);
+            return rv;
+        }
+        rv = 0;
+    }
+
+    if (PROXY_Out.Count == PROXY_OUT_QUEUE_DEPTH || PROXY_Out.Bytes + Length > PROXY_OUT_QUEUE_BYTES)
+    {
+        PROXY_Out.Drops++;
+        if (PROXY_OUT_OVERFLOW_POLICY == PROXY_OUT_RESTART)
+        {
+            __atomic_store_n(&PROXY_Out.RestartPending, true, __ATOMIC_RELEASE);
+        }
+        nng_mtx_unlock(PROXY_Out.Mutex);
+        return 0;
+    }
+
+    rv = nng_msg_alloc(&msg, 0);
+    if (rv == 0)
+    {
+        rv = nng_msg_append(msg, Data, Length);
+        if (rv != 0)
+        {
+            nng_msg_free(msg);
+        }
+    }
+    if (rv != 0)
+    {
+        nng_mtx_unlock(PROXY_Out.Mutex);
+        return rv;
+    }
+
+    Entry         = &PROXY_Out.Queue[(PROXY_Out.Head + PROXY_Out.Count) % PROXY_OUT_QUEUE_DEPTH];
+    Entry->Msg    = msg;
+    Entry->Sock   = Sock;
+    Entry->Length = Length;
+    PROXY_Out.Count++;
+    PROXY_Out.Queued++;
+    PROXY_Out.Bytes += Length;
+    if (PROXY_Out.Bytes > PROXY_Out.HighWater)
+    {
+        PROXY_Out.HighWater = PROXY_Out.Bytes;
+    }
+
+    if (!PROXY_Out.Busy)
+    {
+        PROXY_OutStartHead();
+    }
+
+    nng_mtx_unlock(PROXY_Out.Mutex);
+
+    return 0;
+} /* End of PROXY_OutSend() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_OutSendDone                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         aio callback: the message in flight was sent (or failed), start    */
+/*         the next one.                                                      */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+static void PROXY_OutSendDone(void *Arg)
+{
+    int rv = nng_aio_result(PROXY_Out.Aio);
+
+    nng_mtx_lock(PROXY_Out.Mutex);
+
+    if (rv != 0)
+    {
+        // The message is still ours on failure
+        nng_msg_free(nng_aio_get_msg(PROXY_Out.Aio));
+        if (rv != NNG_ECANCELED)
+        {
+            PROXY_Out.LastError = rv;
+        }
+    }
+
+    PROXY_OutPopHead();
+    if (PROXY_Out.Count > 0)
+    {
+        PROXY_OutStartHead();
+    }
+    else
+    {
+        PROXY_Out.Busy = false;
+    }
+
+    nng_mtx_unlock(PROXY_Out.Mutex);
+} /* End of PROXY_OutSendDone() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_OutReset                                                     */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Drops everything queued, for an actual app that is gone. Returns   */
+/*         the replies dropped, the one in flight included.                   */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+uint32 PROXY_OutReset(void)
+{
+    PROXY_OutEntry_t *Entry;
+    uint32            keep;
+    uint32            dropped;
+
+    if (PROXY_Out.Aio == NULL)
+    {
+        return 0;
+    }
+
+    nng_mtx_lock(PROXY_Out.Mutex);
+    keep    = PROXY_Out.Busy ? 1 : 0;
+    dropped = PROXY_Out.Count;
+    while (PROXY_Out.Count > keep)
+    {
+        Entry = &PROXY_Out.Queue[(PROXY_Out.Head + PROXY_Out.Count - 1) % PROXY_OUT_QUEUE_DEPTH];
+        nng_msg_free(Entry->Msg);
+        PROXY_Out.Bytes -= Entry->Length;
+        PROXY_Out.Count--;
+    }
+    __atomic_store_n(&PROXY_Out.RestartPending, false, __ATOMIC_RELEASE);
+    nng_mtx_unlock(PROXY_Out.Mutex);
+
+    // Cancel the message in flight, the callback frees it
+    nng_aio_cancel(PROXY_Out.Aio);
+    nng_aio_wait(PROXY_Out.Aio);
+
+    return dropped;
+} /* End of PROXY_OutReset() */
+
+void PROXY_OutCleanup(void)
+{
+    if (PROXY_Out.Aio != NULL)
+    {
+        PROXY_OutReset();
+        nng_aio_stop(PROXY_Out.Aio);
+        nng_aio_free(PROXY_Out.Aio);
+        PROXY_Out.Aio = NULL;
+    }
+
+    if (PROXY_Out.Mutex != NULL)
+    {
+        nng_mtx_free(PROXY_Out.Mutex);
+        PROXY_Out.Mutex = NULL;
+    }
+}
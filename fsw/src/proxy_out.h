@@ -0,0 +1,67 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_out_h
+#define proxy_out_h
+
+#include "proxy.h"
+#include "proxy_defs.h"
+
+#include <nng/supplemental/util/platform.h>
+
+/* What to do when a reply does not fit in the outbound queue (PROXY_OUT_OVERFLOW_POLICY) */
+#define PROXY_OUT_DROP          0   /* drop the reply, the actual app has to time out */
+#define PROXY_OUT_RESTART       1   /* drop the queue, restart the actual app */
+
+typedef struct
+{
+    nng_msg    *Msg;
+    nng_socket  Sock;
+    size_t      Length;
+} PROXY_OutEntry_t;
+
+/*
+** Outbound queue
+**
+** Replies the socket does not take right away are queued here and sent one at a time with
+** an aio, so a stalled actual app never blocks the proxy task. The head of the queue is the
+** message in flight while Busy.
+*/
+typedef struct
+{
+    nng_mtx          *Mutex;
+    nng_aio          *Aio;
+    bool              Busy;
+    uint32            Head;
+    uint32            Count;
+    PROXY_OutEntry_t  Queue[PROXY_OUT_QUEUE_DEPTH];
+
+    uint32            Bytes;          // queued, including the message in flight
+    uint32            HighWater;      // most bytes queued
+    uint32            Queued;         // replies that went through the queue
+    uint32            Drops;          // replies dropped on overflow
+    int32             LastError;      // last failed send
+    bool              RestartPending; // overflow with PROXY_OUT_RESTART, handled by the proxy task
+} PROXY_Out_t;
+
+extern PROXY_Out_t PROXY_Out;
+
+int    PROXY_OutInit(void);
+int    PROXY_OutSend(nng_socket Sock, const void *Data, size_t Length);
+uint32 PROXY_OutReset(void);
+void   PROXY_OutCleanup(void);
+
+static inline bool PROXY_OutRestartRequested(void)
+{
+    return __atomic_load_n(&PROXY_Out.RestartPending, __ATOMIC_ACQUIRE);
+}
+
+#endif /* proxy_out_h */
@@ -0,0 +1,159 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Perf marker ring:
+ * The client stamps its CFE_ES_PerfLogAdd markers with its own CLOCK_MONOTONIC time and
+ * writes them to a shared ring (see proxy_ipc.h), so a marker costs a few stores instead
+ * of a round trip. The proxy task drains the rings before each message it services and
+ * once per pass of the run loop.
+ *
+ * Drained markers go to the RPC trace timeline with the client's times, which share the
+ * clock of the proxy's own trace events. With PROXY_PERF_CFE_LOG they are also added to the
+ * cFE perf log; CFE_ES_PerfLogAdd can not take a time, so there they keep their order but
+ * are stamped when drained.
+ */
+
+#include "proxy_perf.h"
+#include "proxy_ctrl.h"
+#include "proxy_pool.h"
+#include "proxy_trace.h"
+#include "proxy_handover.h"
+#include "proxy_events.h"
+#include "proxy_shm.h"
+#include "proxy_defs.h"
+
+
+PROXY_Perf_t PROXY_Perf;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_PerfMapRing                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Creates the ring of an endpoint the first time a client there      */
+/*         negotiates the feature. Returns false (and reports) if it can not  */
+/*         be created, the feature is then not offered.                       */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+bool PROXY_PerfMapRing(uint8 Endpoint)
+{
+    PROXY_PerfRing_t *Ring = &PROXY_Perf.Rings[Endpoint];
+
+    if (Ring->Ring != NULL)
+    {
+        return true;
+    }
+
+    snprintf(Ring->ShmName, sizeof(Ring->ShmName), "%s_perf%u", PROXY_SHM_PREFIX, (unsigned int) Endpoint);
+
+    // The client writes the markers, so it maps the ring read-write
+    Ring->Ring = PROXY_ShmCreate(Ring->ShmName, sizeof(PROXY_ShmPerf_t), 0600, PROXY_PERF_ERR_EID);
+    if (Ring->Ring == NULL)
+    {
+        return false;
+    }
+
+    // Left by an earlier proxy perhaps, the ring starts empty
+    memset(Ring->Ring, 0, sizeof(PROXY_ShmPerf_t));
+
+    return true;
+} /* End of PROXY_PerfMapRing() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_PerfDrainRing                                                */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Takes every marker written so far and frees the slots for the      */
+/*         client.                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_PerfDrainRing(PROXY_ShmPerf_t *Ring)
+{
+    const PROXY_PerfMarker_t *Marker;
+    uint32 head = __atomic_load_n(&Ring->Head, __ATOMIC_ACQUIRE);
+    uint32 tail = Ring->Tail;
+
+    // A Head that is not possible is not trusted further than one ring
+    if (head - tail > PROXY_PERF_RING_ENTRIES)
+    {
+        tail = head - PROXY_PERF_RING_ENTRIES;
+    }
+
+    for (; tail != head; tail++)
+    {
+        Marker = &Ring->Markers[tail % PROXY_PERF_RING_ENTRIES];
+
+        if (PROXY_PERF_CFE_LOG)
+        {
+            CFE_ES_PerfLogAdd(Marker->Marker, Marker->EntryExit);
+        }
+        PROXY_TraceMarker(Marker);
+        PROXY_Perf.Markers++;
+    }
+
+    __atomic_store_n(&Ring->Tail, tail, __ATOMIC_RELEASE);
+} /* End of PROXY_PerfDrainRing() */
+
+// Markers the clients could not write because a ring was full
+uint32 PROXY_PerfDropped(void)
+{
+    uint32 dropped = 0;
+    uint32 index;
+
+    for (index = 0; index < 2; index++)
+    {
+        if (PROXY_Perf.Rings[index].Ring != NULL)
+        {
+            dropped += __atomic_load_n(&PROXY_Perf.Rings[index].Ring->Dropped, __ATOMIC_RELAXED);
+        }
+    }
+
+    return dropped;
+}
+
+// Answers PROXY_CTRL_PERF_MAP with the ring of the endpoint the client is on
+void PROXY_PerfProcessCtrl(const void *Buffer, size_t Size)
+{
+    PROXY_CtrlPerfReply_t Reply;
+    PROXY_PerfRing_t     *Ring = &PROXY_Perf.Rings[PROXY_HandoverEndpoint(PROXY_MainCtx.Sock)];
+
+    if (!PROXY_CtrlCheckLength(Buffer, Size, sizeof(PROXY_CtrlPerfMap_t)))
+    {
+        return;
+    }
+
+    memset(&Reply, 0, sizeof(Reply));
+    PROXY_CtrlInitHdr(&Reply.Hdr, PROXY_CTRL_PERF_REPLY, sizeof(Reply));
+    if ((PROXY_CtrlFeatures() & PROXY_FEATURE_PERF_RING) && Ring->Ring != NULL)
+    {
+        Reply.Status  = CFE_SUCCESS;
+        Reply.Entries = PROXY_PERF_RING_ENTRIES;
+        strncpy(Reply.ShmName, Ring->ShmName, sizeof(Reply.ShmName) - 1);
+    }
+    else
+    {
+        Reply.Status = CFE_STATUS_NOT_IMPLEMENTED;
+    }
+
+    send_reply(__func__, &Reply, sizeof(Reply));
+}
+
+void PROXY_PerfCleanup(void)
+{
+    uint32 index;
+
+    for (index = 0; index < 2; index++)
+    {
+        if (PROXY_Perf.Rings[index].Ring != NULL)
+        {
+            PROXY_ShmDestroy(PROXY_Perf.Rings[index].Ring, sizeof(PROXY_ShmPerf_t), PROXY_Perf.Rings[index].ShmName);
+            PROXY_Perf.Rings[index].Ring = NULL;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_perf_h
+#define proxy_perf_h
+
+#include "proxy.h"
+#include "proxy_ipc.h"
+
+typedef struct
+{
+    PROXY_ShmPerf_t *Ring;        // NULL until a client on the endpoint negotiates the feature
+    char             ShmName[PROXY_SHM_NAME_LEN];
+} PROXY_PerfRing_t;
+
+/*
+** Perf marker rings, one per endpoint so that the old app and its replacement never write
+** the same ring during a handover. Only used on the proxy task.
+*/
+typedef struct
+{
+    PROXY_PerfRing_t Rings[2];
+    uint32           Markers;     // drained from the rings
+} PROXY_Perf_t;
+
+extern PROXY_Perf_t PROXY_Perf;
+
+bool   PROXY_PerfMapRing(uint8 Endpoint);
+void   PROXY_PerfProcessCtrl(const void *Buffer, size_t Size);
+void   PROXY_PerfDrainRing(PROXY_ShmPerf_t *Ring);
+uint32 PROXY_PerfDropped(void);
+void   PROXY_PerfCleanup(void);
+
+// Drains whatever the clients wrote, cheap when the rings are empty
+static inline void PROXY_PerfDrain(void)
+{
+    PROXY_ShmPerf_t *Ring;
+    uint32 index;
+
+    for (index = 0; index < 2; index++)
+    {
+        Ring = PROXY_Perf.Rings[index].Ring;
+        if (Ring != NULL && __atomic_load_n(&Ring->Head, __ATOMIC_ACQUIRE) != Ring->Tail)
+        {
+            PROXY_PerfDrainRing(Ring);
+        }
+    }
+}
+
+#endif /* proxy_perf_h */
@@ -0,0 +1,372 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Worker pool:
+ * The proxy task receives the messages and hands the remote calls (and batches of them) to a
+ * small pool of child tasks, so a slow cFE call does not hold up the command pipe or the
+ * other connections. Each origin (the socket a call came from, one per actual app) is always
+ * served by the same worker, which keeps the calls of an actual app in order, and the reply
+ * is sent back on the socket the call came from.
+ *
+ * Calls that change the state of the proxy app itself (RunLoop, RegisterApp, ExitApp) and
+ * the control frames other than BATCH stay on the proxy task. They wait for the origin's
+ * worker to finish what was queued before them, so ordering still holds.
+ */
+
+#include "proxy_pool.h"
+#include "proxy_ctrl.h"
+#include "proxy_events.h"
+#include "proxy_defs.h"
+
+// Flat Buff Stuff
+#include <cfs_api_builder.h>
+#undef ns
+#define ns(x) FLATBUFFERS_WRAP_NAMESPACE(cFS_API, x)
+
+/*
+** A message queued for a worker, the worker frees Buffer
+*/
+typedef struct
+{
+    char       *Buffer;      // NULL asks the worker to exit
+    size_t      Size;
+    nng_socket  Sock;
+    uint64      RecvNs;
+    uint64      QueuedNs;
+} PROXY_Job_t;
+
+typedef struct
+{
+    osal_id_t         QueueId;
+    CFE_ES_TaskId_t   TaskId;
+    bool              Created;
+    uint32            Pending;    // queued or being serviced
+    flatcc_builder_t  Builder;
+    PROXY_CallCtx_t   Ctx;
+} PROXY_Worker_t;
+
+PROXY_Pool_t PROXY_Pool;
+
+static PROXY_Worker_t PROXY_Workers[PROXY_WORKER_POOL_SIZE > 0 ? PROXY_WORKER_POOL_SIZE : 1];
+
+// Loop bound, with the default size of 0 a literal bound is a comparison that is always false
+static const uint32   PROXY_WorkerCount = PROXY_WORKER_POOL_SIZE;
+
+static void PROXY_WorkerTask(void);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_PoolInit                                                     */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Creates the worker queues and tasks. If a worker can not be        */
+/*         created the pool is smaller, with no workers calls are serviced    */
+/*         inline.                                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_PoolInit(void)
+{
+    PROXY_Worker_t *Worker;
+    char   name[OS_MAX_API_NAME];
+    uint32 index;
+    int32  status;
+
+    for (index = 0; index < PROXY_WorkerCount; index++)
+    {
+        Worker = &PROXY_Workers[index];
+
+        snprintf(name, sizeof(name), "PROXY_WORKER%u", (unsigned int) index);
+        status = OS_QueueCreate(&Worker->QueueId, name, PROXY_WORKER_QUEUE_DEPTH, sizeof(PROXY_Job_t), 0);
+        if (status != OS_SUCCESS)
+        {
+            CFE_EVS_SendEventWithAppID(PROXY_POOL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                       "PROXY: worker queue %u creation failed: %d", (unsigned int) index, (int) status);
+            break;
+        }
+
+        flatcc_builder_init(&Worker->Builder);
+        Worker->Ctx.Builder = &Worker->Builder;
+
+        // The task looks its worker up by its TaskId, see PROXY_WorkerFind
+        status = CFE_ES_CreateChildTask(&Worker->TaskId, name, PROXY_WorkerTask, CFE_ES_TASK_STACK_ALLOCATE,
+                                        PROXY_WORKER_STACK_SIZE, PROXY_WORKER_PRIORITY, 0);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEventWithAppID(PROXY_POOL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                       "PROXY: worker task %u creation failed: 0x%08X", (unsigned int) index,
+                                       (unsigned int) status);
+            flatcc_builder_clear(&Worker->Builder);
+            OS_QueueDelete(Worker->QueueId);
+            break;
+        }
+        __atomic_store_n(&Worker->Created, true, __ATOMIC_RELEASE);
+        PROXY_Pool.Size++;
+    }
+} /* End of PROXY_PoolInit() */
+
+// Calls on the state of the proxy app itself, they are never given to a worker
+static bool PROXY_PoolInlineCall(const char *Buffer)
+{
+    switch (ns(RemoteCall_input_type(ns(RemoteCall_as_root(Buffer)))))
+    {
+        case ns(Function_RunLoop):
+        case ns(Function_RegisterApp):
+        case ns(Function_ExitApp):
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// A batch goes to a worker only if none of its calls has to be inline
+static bool PROXY_PoolInlineBatch(const PROXY_CtrlBatch_t *Batch, size_t Size)
+{
+    const PROXY_CtrlBatchEntry_t *Entry;
+    size_t offset = sizeof(PROXY_CtrlBatch_t);
+    uint16 index;
+
+    for (index = 0; index < Batch->Count; index++)
+    {
+        Entry = PROXY_CtrlBatchEntry(Batch, Size, &offset);
+        if (Entry == NULL || PROXY_PoolInlineCall((const char *) (Entry + 1)))
+        {
+            // A malformed batch is reported by the proxy task
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Waits until the worker has serviced everything queued for it
+static void PROXY_PoolWaitIdle(PROXY_Worker_t *Worker)
+{
+    if (__atomic_load_n(&Worker->Pending, __ATOMIC_ACQUIRE) != 0)
+    {
+        PROXY_Pool.InlineWaits++;
+        while (__atomic_load_n(&Worker->Pending, __ATOMIC_ACQUIRE) != 0)
+        {
+            OS_TaskDelay(1);
+        }
+    }
+}
+
+// Waits until every worker has serviced everything queued for it, so no reply of an
+// earlier call can be sent after this returns
+void PROXY_PoolWaitAll(void)
+{
+    uint32 index;
+
+    for (index = 0; index < PROXY_Pool.Size; index++)
+    {
+        while (__atomic_load_n(&PROXY_Workers[index].Pending, __ATOMIC_ACQUIRE) != 0)
+        {
+            OS_TaskDelay(1);
+        }
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_PoolDispatch                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Queues a message for the worker of its origin. Returns false when  */
+/*         the message has to be serviced by the proxy task, the caller keeps */
+/*         the buffer. On true the worker owns and frees the buffer.          */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+bool PROXY_PoolDispatch(char *Buffer, size_t Size, nng_socket Sock, uint64 RecvNs)
+{
+    PROXY_Worker_t *Worker;
+    PROXY_Job_t     Job;
+    uint32          depth;
+    int32           status;
+
+    if (PROXY_Pool.Size == 0)
+    {
+        return false;
+    }
+
+    Worker = &PROXY_Workers[(uint32) nng_socket_id(Sock) % PROXY_Pool.Size];
+
+    if (PROXY_IsCtrlFrame(Buffer, Size))
+    {
+        if (((const PROXY_CtrlHdr_t *) Buffer)->Type != PROXY_CTRL_BATCH || Size < sizeof(PROXY_CtrlBatch_t) ||
+            PROXY_PoolInlineBatch((const PROXY_CtrlBatch_t *) Buffer, Size))
+        {
+            PROXY_PoolWaitIdle(Worker);
+            return false;
+        }
+    }
+    else if (PROXY_PoolInlineCall(Buffer))
+    {
+        PROXY_PoolWaitIdle(Worker);
+        return false;
+    }
+
+    Job.Buffer   = Buffer;
+    Job.Size     = Size;
+    Job.Sock     = Sock;
+    Job.RecvNs   = RecvNs;
+    Job.QueuedNs = PROXY_MonotonicNs();
+
+    __atomic_fetch_add(&Worker->Pending, 1, __ATOMIC_ACQ_REL);
+    depth = __atomic_add_fetch(&PROXY_Pool.Depth, 1, __ATOMIC_RELAXED);
+    if (depth > PROXY_Pool.DepthMax)
+    {
+        PROXY_Pool.DepthMax = depth;
+    }
+
+    // Waiting for room keeps the order of the calls, the actual app is throttled instead
+    while ((status = OS_QueuePut(Worker->QueueId, &Job, sizeof(Job), 0)) == OS_QUEUE_FULL)
+    {
+        PROXY_Pool.QueueFull++;
+        OS_TaskDelay(1);
+    }
+
+    if (status != OS_SUCCESS)
+    {
+        __atomic_fetch_sub(&PROXY_Pool.Depth, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&Worker->Pending, 1, __ATOMIC_ACQ_REL);
+        CFE_EVS_SendEventWithAppID(PROXY_POOL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: worker queue put failed: %d, serviced inline", (int) status);
+        PROXY_PoolWaitIdle(Worker);
+        return false;
+    }
+
+    PROXY_Pool.Jobs++;
+
+    return true;
+} /* End of PROXY_PoolDispatch() */
+
+// The worker of the calling task. A task may start before PROXY_PoolInit has recorded its
+// TaskId, so it waits until its worker is marked created.
+static PROXY_Worker_t *PROXY_WorkerFind(void)
+{
+    CFE_ES_TaskId_t TaskId;
+    uint32 index;
+
+    CFE_ES_GetTaskID(&TaskId);
+
+    while (true)
+    {
+        for (index = 0; index < PROXY_WorkerCount; index++)
+        {
+            if (__atomic_load_n(&PROXY_Workers[index].Created, __ATOMIC_ACQUIRE) &&
+                CFE_RESOURCEID_TEST_EQUAL(PROXY_Workers[index].TaskId, TaskId))
+            {
+                return &PROXY_Workers[index];
+            }
+        }
+        OS_TaskDelay(1);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_WorkerTask                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Child task servicing the messages queued for one worker.           */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+static void PROXY_WorkerTask(void)
+{
+    PROXY_Worker_t *Worker = PROXY_WorkerFind();
+    PROXY_Job_t     Job;
+    size_t          copied;
+    uint64          wait_ns;
+    uint64          wait_max;
+    int32           status;
+
+    while (true)
+    {
+        status = OS_QueueGet(Worker->QueueId, &Job, sizeof(Job), &copied, OS_PEND);
+        if (status != OS_SUCCESS)
+        {
+            CFE_EVS_SendEventWithAppID(PROXY_POOL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                       "PROXY: worker queue get failed: %d", (int) status);
+            OS_TaskDelay(PROXY_WORKER_ERROR_DELAY_MS);
+            continue;
+        }
+
+        if (Job.Buffer == NULL)
+        {
+            break;
+        }
+
+        wait_ns = PROXY_MonotonicNs() - Job.QueuedNs;
+        // Several workers update these at once
+        __atomic_store_n(&PROXY_Pool.WaitLastNs, wait_ns, __ATOMIC_RELAXED);
+        wait_max = __atomic_load_n(&PROXY_Pool.WaitMaxNs, __ATOMIC_RELAXED);
+        while (wait_ns > wait_max &&
+               !__atomic_compare_exchange_n(&PROXY_Pool.WaitMaxNs, &wait_max, wait_ns, true, __ATOMIC_RELAXED,
+                                            __ATOMIC_RELAXED))
+        {
+        }
+
+        Worker->Ctx.Sock   = Job.Sock;
+        Worker->Ctx.RecvNs = Job.RecvNs;
+        if (PROXY_IsCtrlFrame(Job.Buffer, Job.Size))
+        {
+            PROXY_CtrlBatch(&Worker->Ctx, (const PROXY_CtrlBatch_t *) Job.Buffer, Job.Size);
+        }
+        else
+        {
+            process_remote_call(&Worker->Ctx, Job.Buffer, Job.Size);
+        }
+        nng_free(Job.Buffer, Job.Size);
+
+        __atomic_fetch_sub(&PROXY_Pool.Depth, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&Worker->Pending, 1, __ATOMIC_ACQ_REL);
+    }
+
+    __atomic_store_n(&Worker->Created, false, __ATOMIC_RELEASE);
+    CFE_ES_ExitChildTask();
+} /* End of PROXY_WorkerTask() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_PoolShutdown                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Lets the workers finish what is queued and exit, within a bounded  */
+/*         time, before the proxy exits.                                      */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_PoolShutdown(void)
+{
+    PROXY_Job_t Job = { .Buffer = NULL };
+    uint32 index;
+    int    tries;
+
+    for (index = 0; index < PROXY_Pool.Size; index++)
+    {
+        OS_QueuePut(PROXY_Workers[index].QueueId, &Job, sizeof(Job), 0);
+    }
+
+    for (index = 0; index < PROXY_Pool.Size; index++)
+    {
+        tries = PROXY_WORKER_SHUTDOWN_TRIES;
+        while (tries-- && __atomic_load_n(&PROXY_Workers[index].Created, __ATOMIC_ACQUIRE))
+        {
+            OS_TaskDelay(PROXY_WORKER_ERROR_DELAY_MS);
+        }
+
+        if (__atomic_load_n(&PROXY_Workers[index].Created, __ATOMIC_ACQUIRE))
+        {
+            // Stuck in a cFE call, its builder is left alone
+            CFE_ES_DeleteChildTask(PROXY_Workers[index].TaskId);
+        }
+        else
+        {
+            flatcc_builder_clear(&PROXY_Workers[index].Builder);
+        }
+        OS_QueueDelete(PROXY_Workers[index].QueueId);
+    }
+
+    PROXY_Pool.Size = 0;
+} /* End of PROXY_PoolShutdown() */
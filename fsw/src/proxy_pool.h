@@ -0,0 +1,52 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_pool_h
+#define proxy_pool_h
+
+#include "proxy.h"
+#include "proxy_trace.h"
+
+struct flatcc_builder;
+
+struct PROXY_CallCtx
+{
+    struct flatcc_builder *Builder;
+    nng_socket             Sock;     // origin of the call, the reply goes back on it
+    uint64                 RecvNs;   // when the call came off the socket
+    PROXY_TraceEntry_t     Trace;
+};
+
+/*
+** Worker pool statistics. With PROXY_WORKER_POOL_SIZE 0 there are no workers and every
+** call is serviced by the proxy task, as before.
+*/
+typedef struct
+{
+    uint32  Size;          // worker tasks running
+    uint32  Jobs;          // messages handed to the workers
+    uint32  Depth;         // messages queued or being serviced now
+    uint32  DepthMax;
+    uint32  QueueFull;     // times the proxy task waited for room in a worker queue
+    uint32  InlineWaits;   // times an inline call waited for its worker to catch up
+    uint64  WaitLastNs;    // time the last message spent queued
+    uint64  WaitMaxNs;
+} PROXY_Pool_t;
+
+extern PROXY_Pool_t    PROXY_Pool;
+extern PROXY_CallCtx_t PROXY_MainCtx;
+
+void PROXY_PoolInit(void);
+bool PROXY_PoolDispatch(char *Buffer, size_t Size, nng_socket Sock, uint64 RecvNs);
+void PROXY_PoolWaitAll(void);
+void PROXY_PoolShutdown(void);
+
+#endif /* proxy_pool_h */
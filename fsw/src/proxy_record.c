@@ -0,0 +1,275 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Record mode:
+ * Every RemoteCall received from the actual app and every reply sent back is copied,
+ * with a monotonic timestamp, into an in-memory ring. A child task drains the ring to
+ * the capture file, so the proxy task never waits on the file system. If the ring is
+ * full the frame is dropped and counted rather than stalling the proxy.
+ *
+ * The file format is described in proxy_record_format.h, tools/proxy_replay plays it back.
+ */
+
+#include "proxy_record.h"
+#include "proxy_events.h"
+#include "proxy_defs.h"
+
+#include <fcntl.h>
+
+PROXY_Record_t PROXY_Record = { .State = PROXY_RECORD_IDLE, .Fd = -1 };
+
+static uint8 PROXY_RecordRing[PROXY_RECORD_RING_SIZE];
+
+static void PROXY_RecordWriterTask(void);
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_RecordStart                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Opens the capture file and starts recording. An empty filename     */
+/*         uses PROXY_RECORD_FILE.                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_RecordStart(const char *Filename)
+{
+    PROXY_RecordFileHdr_t FileHdr;
+    int32 status;
+
+    if (Filename[0] == '\0')
+    {
+        Filename = PROXY_RECORD_FILE;
+    }
+
+    if (__atomic_load_n(&PROXY_Record.State, __ATOMIC_ACQUIRE) != PROXY_RECORD_IDLE)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_RECORD_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: record already active or still flushing");
+        return;
+    }
+
+    PROXY_Record.Fd = open(Filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (PROXY_Record.Fd < 0)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_RECORD_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: record can not open %s: %s", Filename, strerror(errno));
+        return;
+    }
+
+    FileHdr.Magic   = PROXY_RECORD_MAGIC;
+    FileHdr.Version = PROXY_RECORD_VERSION;
+    FileHdr.Spare   = 0;
+    if (write(PROXY_Record.Fd, &FileHdr, sizeof(FileHdr)) != sizeof(FileHdr))
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_RECORD_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: record can not write %s: %s", Filename, strerror(errno));
+        close(PROXY_Record.Fd);
+        PROXY_Record.Fd = -1;
+        return;
+    }
+
+    if (!PROXY_Record.WriterCreated)
+    {
+        // Replies are also recorded by the worker pool tasks
+        status = OS_MutSemCreate(&PROXY_Record.ProducerMutex, "PROXY_RECORD", 0);
+        if (status != OS_SUCCESS)
+        {
+            CFE_EVS_SendEventWithAppID(PROXY_RECORD_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                       "PROXY: record mutex creation failed: %d", (int)status);
+            close(PROXY_Record.Fd);
+            PROXY_Record.Fd = -1;
+            return;
+        }
+
+        status = CFE_ES_CreateChildTask(&PROXY_Record.WriterTaskId, "PROXY_RECORD", PROXY_RecordWriterTask,
+                                        CFE_ES_TASK_STACK_ALLOCATE, PROXY_RECORD_STACK_SIZE,
+                                        PROXY_RECORD_PRIORITY, 0);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEventWithAppID(PROXY_RECORD_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                       "PROXY: record writer task creation failed: 0x%08X", (unsigned int)status);
+            // Created again by the next start, its name would be taken
+            OS_MutSemDelete(PROXY_Record.ProducerMutex);
+            close(PROXY_Record.Fd);
+            PROXY_Record.Fd = -1;
+            return;
+        }
+        PROXY_Record.WriterCreated = true;
+    }
+
+    // The writer is idle, so the ring is empty and can be rewound. A worker that saw the
+    // previous recording still active may be in PROXY_RecordFrame, the lock keeps it out.
+    OS_MutSemTake(PROXY_Record.ProducerMutex);
+    PROXY_Record.Head       = 0;
+    PROXY_Record.Tail       = 0;
+    PROXY_Record.Frames     = 0;
+    PROXY_Record.Drops      = 0;
+    PROXY_Record.WriteErrno = 0;
+    OS_MutSemGive(PROXY_Record.ProducerMutex);
+
+    __atomic_store_n(&PROXY_Record.State, PROXY_RECORD_ACTIVE, __ATOMIC_RELEASE);
+
+    CFE_EVS_SendEventWithAppID(PROXY_RECORD_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: recording to %s", Filename);
+} /* End of PROXY_RecordStart() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_RecordStop                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Stops recording. The writer flushes what is left in the ring and   */
+/*         closes the file in the background.                                 */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_RecordStop(void)
+{
+    if (__atomic_load_n(&PROXY_Record.State, __ATOMIC_ACQUIRE) != PROXY_RECORD_ACTIVE)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_RECORD_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: record not active");
+        return;
+    }
+
+    __atomic_store_n(&PROXY_Record.State, PROXY_RECORD_CLOSING, __ATOMIC_RELEASE);
+
+    CFE_EVS_SendEventWithAppID(PROXY_RECORD_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: record stopped, %u frames, %u dropped",
+                               (unsigned int)PROXY_Record.Frames, (unsigned int)PROXY_Record.Drops);
+} /* End of PROXY_RecordStop() */
+
+// Copy into the ring at a free running offset, wrapping as needed
+static void PROXY_RecordCopyIn(uint32 Offset, const void *Data, size_t Length)
+{
+    uint32 index = Offset % PROXY_RECORD_RING_SIZE;
+    size_t first = PROXY_RECORD_RING_SIZE - index;
+
+    if (first > Length)
+    {
+        first = Length;
+    }
+    memcpy(&PROXY_RecordRing[index], Data, first);
+    memcpy(&PROXY_RecordRing[0], (const uint8 *)Data + first, Length - first);
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_RecordFrameSlow                                              */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Appends one frame to the ring. Called through PROXY_RecordFrame    */
+/*         only while recording.                                              */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_RecordFrameSlow(uint16 Kind, const void *Data, size_t Length)
+{
+    PROXY_RecordHdr_t Hdr;
+    uint32 head, tail;
+    size_t needed = sizeof(Hdr) + Length;
+
+    OS_MutSemTake(PROXY_Record.ProducerMutex);
+
+    head = PROXY_Record.Head;
+    tail = __atomic_load_n(&PROXY_Record.Tail, __ATOMIC_ACQUIRE);
+    if (needed > PROXY_RECORD_RING_SIZE - (head - tail))
+    {
+        PROXY_Record.Drops++;
+        OS_MutSemGive(PROXY_Record.ProducerMutex);
+        return;
+    }
+
+    Hdr.Length  = Length;
+    Hdr.Kind    = Kind;
+    Hdr.Replies = (Kind == PROXY_RECORD_REQUEST) ? PROXY_ExpectedReplies(Data, Length) : 0;
+    Hdr.TimeNs  = PROXY_MonotonicNs();
+
+    PROXY_RecordCopyIn(head, &Hdr, sizeof(Hdr));
+    PROXY_RecordCopyIn(head + sizeof(Hdr), Data, Length);
+
+    __atomic_store_n(&PROXY_Record.Head, head + needed, __ATOMIC_RELEASE);
+    PROXY_Record.Frames++;
+
+    OS_MutSemGive(PROXY_Record.ProducerMutex);
+} /* End of PROXY_RecordFrameSlow() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_RecordWriterTask                                             */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Child task that drains the ring to the capture file, and closes    */
+/*         the file once recording has stopped and the ring is empty.         */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static void PROXY_RecordWriterTask(void)
+{
+    uint32  state, head, tail, index;
+    size_t  chunk;
+    ssize_t written;
+
+    while (true)
+    {
+        state = __atomic_load_n(&PROXY_Record.State, __ATOMIC_ACQUIRE);
+        head  = __atomic_load_n(&PROXY_Record.Head, __ATOMIC_ACQUIRE);
+        tail  = PROXY_Record.Tail;
+
+        if (head != tail)
+        {
+            // Write the contiguous part, the wrapped part goes on the next pass
+            index = tail % PROXY_RECORD_RING_SIZE;
+            chunk = head - tail;
+            if (chunk > PROXY_RECORD_RING_SIZE - index)
+            {
+                chunk = PROXY_RECORD_RING_SIZE - index;
+            }
+
+            written = write(PROXY_Record.Fd, &PROXY_RecordRing[index], chunk);
+            if (written < 0)
+            {
+                // Keep draining so the proxy task is not blocked, the capture is lost anyway
+                PROXY_Record.WriteErrno = errno;
+                written = chunk;
+            }
+            __atomic_store_n(&PROXY_Record.Tail, tail + written, __ATOMIC_RELEASE);
+        }
+        else if (state == PROXY_RECORD_CLOSING)
+        {
+            close(PROXY_Record.Fd);
+            PROXY_Record.Fd = -1;
+
+            if (PROXY_Record.WriteErrno != 0)
+            {
+                CFE_EVS_SendEventWithAppID(PROXY_RECORD_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                           "PROXY: record write error: %s", strerror(PROXY_Record.WriteErrno));
+            }
+            __atomic_store_n(&PROXY_Record.State, PROXY_RECORD_IDLE, __ATOMIC_RELEASE);
+        }
+        else
+        {
+            OS_TaskDelay(PROXY_RECORD_WRITER_DELAY_MS);
+        }
+    }
+} /* End of PROXY_RecordWriterTask() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_RecordShutdown                                               */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Stops an active recording and gives the writer a bounded amount of */
+/*         time to flush it before the proxy exits.                           */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_RecordShutdown(void)
+{
+    int tries = PROXY_RECORD_SHUTDOWN_TRIES;
+
+    if (__atomic_load_n(&PROXY_Record.State, __ATOMIC_ACQUIRE) == PROXY_RECORD_ACTIVE)
+    {
+        PROXY_RecordStop();
+    }
+
+    while (tries-- && __atomic_load_n(&PROXY_Record.State, __ATOMIC_ACQUIRE) != PROXY_RECORD_IDLE)
+    {
+        OS_TaskDelay(PROXY_RECORD_WRITER_DELAY_MS);
+    }
+} /* End of PROXY_RecordShutdown() */
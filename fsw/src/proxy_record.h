@@ -0,0 +1,61 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_record_h
+#define proxy_record_h
+
+#include "proxy.h"
+#include "proxy_record_format.h"
+
+/* Record states */
+#define PROXY_RECORD_IDLE       0
+#define PROXY_RECORD_ACTIVE     1
+#define PROXY_RECORD_CLOSING    2   /* Stopped, the writer is flushing the ring and closing the file */
+
+/*
+** Recorder state
+**
+** The ring is filled by the tasks servicing calls and drained to the file by the writer
+** child task. Producers hold ProducerMutex while appending, Tail is only written by the writer.
+*/
+typedef struct
+{
+    uint32           State;
+    int              Fd;
+    CFE_ES_TaskId_t  WriterTaskId;
+    bool             WriterCreated;
+    osal_id_t        ProducerMutex;
+
+    uint32           Head;      // Free running byte counts, index with % PROXY_RECORD_RING_SIZE
+    uint32           Tail;
+
+    uint32           Frames;
+    uint32           Drops;
+    int32            WriteErrno;
+} PROXY_Record_t;
+
+extern PROXY_Record_t PROXY_Record;
+
+void PROXY_RecordStart(const char *Filename);
+void PROXY_RecordStop(void);
+void PROXY_RecordShutdown(void);
+void PROXY_RecordFrameSlow(uint16 Kind, const void *Data, size_t Length);
+
+// The hot path only pays for the state check when not recording
+static inline void PROXY_RecordFrame(uint16 Kind, const void *Data, size_t Length)
+{
+    if (__atomic_load_n(&PROXY_Record.State, __ATOMIC_RELAXED) == PROXY_RECORD_ACTIVE)
+    {
+        PROXY_RecordFrameSlow(Kind, Data, Length);
+    }
+}
+
+#endif /* proxy_record_h */
@@ -0,0 +1,77 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Shared memory objects:
+ * The pages and rings the proxy shares with the client (tables, CDS mirrors, EVS filters,
+ * perf rings, ES page, statistics) are POSIX shared memory objects named PROXY_SHM_PREFIX
+ * and a suffix. An object left by an earlier proxy may still be mapped by a client or a
+ * monitor, so it is reused and only ever grown: truncating it would turn their accesses
+ * past the new end into SIGBUS. The caller initializes the contents.
+ */
+
+#include "proxy_shm.h"
+#include "proxy_events.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_ShmCreate                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Opens or creates the object Name, at least Size bytes long, and    */
+/*         maps it read-write. Returns NULL (and reports with Eid) on error,  */
+/*         the object is then removed.                                        */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void *PROXY_ShmCreate(const char *Name, size_t Size, mode_t Mode, uint16 Eid)
+{
+    struct stat st;
+    void       *map;
+    int         fd;
+
+    fd = shm_open(Name, O_CREAT | O_RDWR, Mode);
+    if (fd < 0)
+    {
+        CFE_EVS_SendEventWithAppID(Eid, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: shm_open %s failed: %s", Name, strerror(errno));
+        return NULL;
+    }
+
+    if (fstat(fd, &st) != 0 || ((size_t) st.st_size < Size && ftruncate(fd, Size) != 0))
+    {
+        CFE_EVS_SendEventWithAppID(Eid, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: ftruncate %s failed: %s", Name, strerror(errno));
+        close(fd);
+        shm_unlink(Name);
+        return NULL;
+    }
+
+    map = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        CFE_EVS_SendEventWithAppID(Eid, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: mmap %s failed: %s", Name, strerror(errno));
+        shm_unlink(Name);
+        return NULL;
+    }
+
+    return map;
+} /* End of PROXY_ShmCreate() */
+
+// Unmaps an object of PROXY_ShmCreate and removes its name, clients keep their mappings
+void PROXY_ShmDestroy(void *Map, size_t Size, const char *Name)
+{
+    munmap(Map, Size);
+    shm_unlink(Name);
+}
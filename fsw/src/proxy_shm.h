@@ -0,0 +1,22 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_shm_h
+#define proxy_shm_h
+
+#include "proxy.h"
+
+#include <sys/types.h>
+
+void *PROXY_ShmCreate(const char *Name, size_t Size, mode_t Mode, uint16 Eid);
+void PROXY_ShmDestroy(void *Map, size_t Size, const char *Name);
+
+#endif /* proxy_shm_h */
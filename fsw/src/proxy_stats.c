@@ -0,0 +1,113 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Statistics page:
+ * Keeps the proxy health in shared memory for monitors outside cFS, see proxy_stats_page.h
+ * for the layout and how to read it. The counters are updated by the proxy task and the
+ * workers as they go, the state block is published by the proxy task at most every
+ * PROXY_STATS_PUBLISH_MS.
+ */
+
+#include "proxy_stats.h"
+#include "proxy_ipc.h"
+#include "proxy_events.h"
+#include "proxy_shm.h"
+#include "proxy_defs.h"
+#include "proxy_out.h"
+#include "proxy_pool.h"
+
+#include <sys/mman.h>
+
+static PROXY_StatsPage_t PROXY_StatsPrivate;
+static char              PROXY_StatsShmName[PROXY_SHM_NAME_LEN];
+
+PROXY_StatsPage_t *PROXY_Stats = &PROXY_StatsPrivate;
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_StatsInit                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Moves the statistics into the shared page. On error they stay in   */
+/*         the private copy and are still reported in housekeeping.           */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_StatsInit(void)
+{
+    void *map;
+
+    snprintf(PROXY_StatsShmName, sizeof(PROXY_StatsShmName), "%s_stats", PROXY_SHM_PREFIX);
+
+    // Read-only for everyone else
+    map = PROXY_ShmCreate(PROXY_StatsShmName, sizeof(PROXY_StatsPage_t), 0644, PROXY_STATS_ERR_EID);
+    if (map == NULL)
+    {
+        return;
+    }
+
+    // Anything counted before the page existed carries over
+    memcpy(map, &PROXY_StatsPrivate, sizeof(PROXY_StatsPage_t));
+    PROXY_Stats = map;
+
+    PROXY_Stats->Version  = PROXY_STATS_VERSION;
+    PROXY_Stats->Size     = sizeof(PROXY_StatsPage_t);
+    PROXY_Stats->ProxyPid = getpid();
+    PROXY_StatsPublish();
+
+    // Written last, a monitor that sees the magic sees a complete page
+    __atomic_store_n(&PROXY_Stats->Magic, PROXY_STATS_MAGIC, __ATOMIC_RELEASE);
+} /* End of PROXY_StatsInit() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_StatsPublish                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Publishes the state block, at most every PROXY_STATS_PUBLISH_MS.   */
+/*         Called by the proxy task only.                                     */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_StatsPublish(void)
+{
+    uint64 now = PROXY_MonotonicNs();
+
+    if (now - PROXY_Stats->PublishNs < (uint64) PROXY_STATS_PUBLISH_MS * 1000000 && PROXY_Stats->PublishNs != 0)
+    {
+        return;
+    }
+
+    __atomic_fetch_add(&PROXY_Stats->Sequence, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    PROXY_Stats->PublishNs      = now;
+    PROXY_Stats->ChildPid       = childPID;
+    PROXY_Stats->ChildState     = PROXY_HkTelemetryPkt.actual_run_state;
+    PROXY_Stats->ChildRestarts  = PROXY_HkTelemetryPkt.actual_reset_count;
+    PROXY_Stats->LaunchStage    = PROXY_HkTelemetryPkt.proxy_launch_stage;
+    PROXY_Stats->ForkError      = PROXY_HkTelemetryPkt.proxy_fork_error;
+    PROXY_Stats->NngError       = PROXY_HkTelemetryPkt.proxy_nng_error;
+    PROXY_Stats->OutError       = PROXY_Out.LastError;
+    PROXY_Stats->CommandCount   = PROXY_HkTelemetryPkt.proxy_command_count;
+    PROXY_Stats->CommandErrors  = PROXY_HkTelemetryPkt.proxy_command_error_count;
+    PROXY_Stats->OutQueuedBytes = PROXY_Out.Bytes;
+    PROXY_Stats->OutHighWater   = PROXY_Out.HighWater;
+    PROXY_Stats->OutDrops       = PROXY_Out.Drops;
+    PROXY_Stats->PoolDepth      = __atomic_load_n(&PROXY_Pool.Depth, __ATOMIC_RELAXED);
+    PROXY_Stats->PoolDepthMax   = PROXY_Pool.DepthMax;
+
+    __atomic_fetch_add(&PROXY_Stats->Sequence, 1, __ATOMIC_RELEASE);
+} /* End of PROXY_StatsPublish() */
+
+// Removes the page at exit, a monitor that still has it mapped keeps the last values
+void PROXY_StatsCleanup(void)
+{
+    if (PROXY_Stats != &PROXY_StatsPrivate)
+    {
+        shm_unlink(PROXY_StatsShmName);
+    }
+}
@@ -0,0 +1,57 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_stats_h
+#define proxy_stats_h
+
+#include "proxy.h"
+#include "proxy_stats_page.h"
+
+/*
+** The page in shared memory, or a private copy if it could not be created, so the hot
+** path never has to check.
+*/
+extern PROXY_StatsPage_t *PROXY_Stats;
+
+void PROXY_StatsInit(void);
+void PROXY_StatsPublish(void);
+void PROXY_StatsCleanup(void);
+
+static inline void PROXY_StatsCount(uint64_t *Counter)
+{
+    __atomic_fetch_add(Counter, 1, __ATOMIC_RELAXED);
+}
+
+// Times a serviced call from when it was received
+static inline void PROXY_StatsCallDone(uint64 RecvNs)
+{
+    uint64 latency = PROXY_MonotonicNs() - RecvNs;
+    uint64 max     = __atomic_load_n(&PROXY_Stats->LatencyMaxNs, __ATOMIC_RELAXED);
+    uint64 us      = latency / 1000;
+    uint32 bucket  = us ? 64 - __builtin_clzll(us) : 0;
+
+    if (bucket >= PROXY_STATS_LATENCY_BUCKETS)
+    {
+        bucket = PROXY_STATS_LATENCY_BUCKETS - 1;
+    }
+
+    __atomic_fetch_add(&PROXY_Stats->Calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&PROXY_Stats->LatencyCount, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&PROXY_Stats->LatencySumNs, latency, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&PROXY_Stats->LatencyHist[bucket], 1, __ATOMIC_RELAXED);
+    while (latency > max &&
+           !__atomic_compare_exchange_n(&PROXY_Stats->LatencyMaxNs, &max, latency, true, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED))
+    {
+    }
+}
+
+#endif /* proxy_stats_h */
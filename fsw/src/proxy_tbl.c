@@ -0,0 +1,337 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Table Services for the actual app:
+ * The proxy registers the tables with cFE (so they belong to the proxy app) and keeps a copy
+ * of each image in a shared memory object the client maps read-only. The copy is refreshed
+ * under a generation counter whenever cFE reports an update, so the client reads tables in
+ * place and only has to poll the counter to see a new image.
+ *
+ * The client can not take part in validation, tables are registered without a validation
+ * function.
+ */
+
+#include "proxy_tbl.h"
+#include "proxy_ctrl.h"
+#include "proxy_events.h"
+#include "proxy_shm.h"
+#include "proxy_defs.h"
+
+PROXY_Tbl_t PROXY_Tables[PROXY_MAX_TABLES];
+uint32      PROXY_TblCount;
+uint32      PROXY_TblRefreshes;
+
+// Returns the table for a client handle, NULL if the handle is not valid
+static PROXY_Tbl_t *PROXY_TblFromHandle(int32 Handle)
+{
+    if (Handle < 0 || Handle >= PROXY_MAX_TABLES || !PROXY_Tables[Handle].InUse)
+    {
+        return NULL;
+    }
+
+    return &PROXY_Tables[Handle];
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_TblRefresh                                                   */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Copies the table image into shared memory if cFE reports an        */
+/*         update, or if no image has been copied yet. Returns the status of  */
+/*         CFE_TBL_GetAddress.                                                */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static int32 PROXY_TblRefresh(PROXY_Tbl_t *Tbl)
+{
+    void *TblAddr;
+    int32 status;
+
+    status = CFE_TBL_GetAddress(&TblAddr, Tbl->TblHandle);
+    if (status != CFE_SUCCESS && status != CFE_TBL_INFO_UPDATED)
+    {
+        // Typically CFE_TBL_ERR_NEVER_LOADED, the address is not held
+        return status;
+    }
+
+    if (status == CFE_TBL_INFO_UPDATED || !Tbl->Shm->Loaded)
+    {
+        // Odd generation while copying, see proxy_ipc.h for the reader side
+        __atomic_fetch_add(&Tbl->Shm->Generation, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        memcpy(Tbl->Shm + 1, TblAddr, Tbl->Size);
+        Tbl->Shm->Loaded = 1;
+        PROXY_TblRefreshes++;
+
+        __atomic_fetch_add(&Tbl->Shm->Generation, 1, __ATOMIC_RELEASE);
+    }
+
+    CFE_TBL_ReleaseAddress(Tbl->TblHandle);
+
+    return status;
+} /* End of PROXY_TblRefresh() */
+
+// Maps the shared image of a new table, returns false (and reports) on error
+static bool PROXY_TblMapShm(PROXY_Tbl_t *Tbl)
+{
+    snprintf(Tbl->ShmName, sizeof(Tbl->ShmName), "%s_tbl_%s", PROXY_SHM_PREFIX, Tbl->Name);
+
+    // World readable, the client maps it with O_RDONLY
+    Tbl->Shm = PROXY_ShmCreate(Tbl->ShmName, sizeof(PROXY_ShmTbl_t) + Tbl->Size, 0644, PROXY_TBL_ERR_EID);
+    if (Tbl->Shm == NULL)
+    {
+        return false;
+    }
+
+    // An image left by an earlier proxy is replaced by the first refresh
+    __atomic_fetch_add(&Tbl->Shm->Generation, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    Tbl->Shm->Size   = Tbl->Size;
+    Tbl->Shm->Loaded = 0;
+    __atomic_fetch_add(&Tbl->Shm->Generation, 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_TblRegister                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Registers a table (or finds the one an earlier client registered)  */
+/*         and maps its shared image. A restarted or replacement client gets  */
+/*         the slot, handle and image of its predecessor back.                */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+static void PROXY_TblRegister(const PROXY_CtrlTblRegister_t *Cmd, PROXY_CtrlTblReply_t *Reply)
+{
+    char         Name[PROXY_TBL_NAME_LEN];
+    PROXY_Tbl_t *Tbl  = NULL;
+    PROXY_Tbl_t *Free = NULL;
+    int32        index;
+
+    memcpy(Name, Cmd->Name, sizeof(Name));
+    Name[sizeof(Name) - 1] = '\0';
+
+    for (index = 0; index < PROXY_MAX_TABLES; index++)
+    {
+        if (!PROXY_Tables[index].InUse)
+        {
+            if (Free == NULL)
+            {
+                Free = &PROXY_Tables[index];
+            }
+        }
+        else if (strcmp(PROXY_Tables[index].Name, Name) == 0)
+        {
+            Tbl = &PROXY_Tables[index];
+            break;
+        }
+    }
+
+    if (Tbl != NULL)
+    {
+        // cFE answers CFE_TBL_WARN_DUPLICATE with the same handle, or refuses another size
+        Reply->Status = CFE_TBL_Register(&Tbl->TblHandle, Name, Cmd->Size, Cmd->Options, NULL);
+        if (Reply->Status < 0)
+        {
+            return;
+        }
+    }
+    else
+    {
+        if (Free == NULL)
+        {
+            Reply->Status = CFE_TBL_ERR_REGISTRY_FULL;
+            return;
+        }
+        Tbl = Free;
+
+        Reply->Status = CFE_TBL_Register(&Tbl->TblHandle, Name, Cmd->Size, Cmd->Options, NULL);
+        if (Reply->Status < 0)
+        {
+            return;
+        }
+
+        strncpy(Tbl->Name, Name, sizeof(Tbl->Name));
+        Tbl->Size = Cmd->Size;
+        if (!PROXY_TblMapShm(Tbl))
+        {
+            CFE_TBL_Unregister(Tbl->TblHandle);
+            Reply->Status = CFE_STATUS_EXTERNAL_RESOURCE_FAIL;
+            return;
+        }
+        Tbl->InUse = true;
+        PROXY_TblCount++;
+    }
+
+    // A table recovered from the CDS already has an image
+    PROXY_TblRefresh(Tbl);
+
+    Reply->Handle = Tbl - PROXY_Tables;
+    strncpy(Reply->ShmName, Tbl->ShmName, sizeof(Reply->ShmName) - 1);
+} /* End of PROXY_TblRegister() */
+
+static void PROXY_TblLoad(const PROXY_CtrlTblLoad_t *Cmd, size_t Size, PROXY_CtrlTblReply_t *Reply)
+{
+    PROXY_Tbl_t *Tbl = PROXY_TblFromHandle(Cmd->Handle);
+    char         Filename[PROXY_PATH_LEN];
+
+    if (Tbl == NULL)
+    {
+        Reply->Status = CFE_TBL_ERR_INVALID_HANDLE;
+        return;
+    }
+
+    if (Cmd->SrcType == CFE_TBL_SRC_ADDRESS)
+    {
+        if (Cmd->DataLength != Tbl->Size || Size < sizeof(*Cmd) + Cmd->DataLength)
+        {
+            Reply->Status = CFE_TBL_ERR_LOAD_INCOMPLETE;
+            return;
+        }
+        Reply->Status = CFE_TBL_Load(Tbl->TblHandle, CFE_TBL_SRC_ADDRESS, Cmd + 1);
+    }
+    else
+    {
+        memcpy(Filename, Cmd->Filename, sizeof(Filename));
+        Filename[sizeof(Filename) - 1] = '\0';
+        Reply->Status = CFE_TBL_Load(Tbl->TblHandle, CFE_TBL_SRC_FILE, Filename);
+    }
+
+    if (Reply->Status >= 0)
+    {
+        PROXY_TblRefresh(Tbl);
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_TblProcessCtrl                                               */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Handles the PROXY_CTRL_TBL_* control frames, each is answered with */
+/*         a PROXY_CTRL_TBL_REPLY.                                            */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_TblProcessCtrl(const void *Buffer, size_t Size)
+{
+    const PROXY_CtrlHdr_t       *Hdr = Buffer;
+    const PROXY_CtrlTblHandle_t *Cmd = Buffer;
+    PROXY_CtrlTblReply_t         Reply;
+    PROXY_Tbl_t                 *Tbl;
+
+    memset(&Reply, 0, sizeof(Reply));
+    PROXY_CtrlInitHdr(&Reply.Hdr, PROXY_CTRL_TBL_REPLY, sizeof(Reply));
+    Reply.Handle = -1;
+
+    // Gated like a batch, the client still gets its reply so it fails fast
+    if ((PROXY_CtrlFeatures() & PROXY_FEATURE_SHM_TABLES) == 0)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_TBL_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: table frame %u received but not negotiated", (unsigned int) Hdr->Type);
+        Reply.Status = CFE_STATUS_NOT_IMPLEMENTED;
+        send_reply(__func__, &Reply, sizeof(Reply));
+        return;
+    }
+
+    switch (Hdr->Type)
+    {
+        case PROXY_CTRL_TBL_REGISTER:
+            if (!PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlTblRegister_t)))
+            {
+                return;
+            }
+            PROXY_TblRegister(Buffer, &Reply);
+            break;
+
+        case PROXY_CTRL_TBL_LOAD:
+            if (!PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlTblLoad_t)))
+            {
+                return;
+            }
+            PROXY_TblLoad(Buffer, Size, &Reply);
+            Reply.Handle = ((const PROXY_CtrlTblLoad_t *) Buffer)->Handle;
+            break;
+
+        default:
+            if (!PROXY_CtrlCheckLength(Hdr, Size, sizeof(PROXY_CtrlTblHandle_t)))
+            {
+                return;
+            }
+            Reply.Handle = Cmd->Handle;
+
+            Tbl = PROXY_TblFromHandle(Cmd->Handle);
+            if (Tbl == NULL)
+            {
+                Reply.Status = CFE_TBL_ERR_INVALID_HANDLE;
+            }
+            else if (Hdr->Type == PROXY_CTRL_TBL_GET_ADDRESS)
+            {
+                Reply.Status = PROXY_TblRefresh(Tbl);
+            }
+            else if (Hdr->Type == PROXY_CTRL_TBL_MANAGE)
+            {
+                Reply.Status = CFE_TBL_Manage(Tbl->TblHandle);
+                PROXY_TblRefresh(Tbl);
+            }
+            else
+            {
+                // The proxy never holds the address on behalf of the client
+                Reply.Status = CFE_SUCCESS;
+            }
+            break;
+    }
+
+    Tbl = PROXY_TblFromHandle(Reply.Handle);
+    if (Tbl != NULL)
+    {
+        Reply.Generation = __atomic_load_n(&Tbl->Shm->Generation, __ATOMIC_ACQUIRE);
+        Reply.Size       = Tbl->Size;
+        strncpy(Reply.ShmName, Tbl->ShmName, sizeof(Reply.ShmName) - 1);
+    }
+
+    send_reply(__func__, &Reply, sizeof(Reply));
+} /* End of PROXY_TblProcessCtrl() */
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_TblManageAll                                                 */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Gives cFE a chance to apply pending loads to every table and      */
+/*         refreshes the shared images. Called with housekeeping.             */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_TblManageAll(void)
+{
+    int32 index;
+
+    for (index = 0; index < PROXY_MAX_TABLES; index++)
+    {
+        if (PROXY_Tables[index].InUse)
+        {
+            CFE_TBL_Manage(PROXY_Tables[index].TblHandle);
+            PROXY_TblRefresh(&PROXY_Tables[index]);
+        }
+    }
+} /* End of PROXY_TblManageAll() */
+
+// Removes the shared images at exit, cFE unregisters the tables with the app
+void PROXY_TblCleanup(void)
+{
+    int32 index;
+
+    for (index = 0; index < PROXY_MAX_TABLES; index++)
+    {
+        if (PROXY_Tables[index].InUse)
+        {
+            PROXY_ShmDestroy(PROXY_Tables[index].Shm, sizeof(PROXY_ShmTbl_t) + PROXY_Tables[index].Size,
+                             PROXY_Tables[index].ShmName);
+            PROXY_Tables[index].InUse = false;
+            PROXY_TblCount--;
+        }
+    }
+}
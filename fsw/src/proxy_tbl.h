@@ -0,0 +1,40 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_tbl_h
+#define proxy_tbl_h
+
+#include "proxy.h"
+#include "proxy_ipc.h"
+#include "proxy_defs.h"
+
+/*
+** A table registered on behalf of the actual app
+*/
+typedef struct
+{
+    bool              InUse;
+    CFE_TBL_Handle_t  TblHandle;
+    char              Name[PROXY_TBL_NAME_LEN];
+    uint32            Size;
+    char              ShmName[PROXY_SHM_NAME_LEN];
+    PROXY_ShmTbl_t   *Shm;            // mapping of the header and image, read-only for the client
+} PROXY_Tbl_t;
+
+extern PROXY_Tbl_t PROXY_Tables[PROXY_MAX_TABLES];
+extern uint32      PROXY_TblCount;
+extern uint32      PROXY_TblRefreshes;
+
+void PROXY_TblProcessCtrl(const void *Buffer, size_t Size);
+void PROXY_TblManageAll(void);
+void PROXY_TblCleanup(void);
+
+#endif /* proxy_tbl_h */
@@ -0,0 +1,186 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * RPC tracing:
+ * While enabled, each remote call gets its receive, dispatch, cFE call and reply times
+ * stamped and stored in a fixed size ring, overwriting the oldest calls. The ring is dumped
+ * on command as Chrome trace JSON, which chrome://tracing and ui.perfetto.dev both open.
+ * Perf markers drained from the actual app (proxy_perf.c) are kept with the times the app
+ * hit them and dumped on a track of their own.
+ */
+
+#include "proxy_trace.h"
+#include "proxy_events.h"
+#include "proxy_defs.h"
+
+// Flat Buff Stuff, for the function names
+#include <cfs_api_builder.h>
+#undef ns
+#define ns(x) FLATBUFFERS_WRAP_NAMESPACE(cFS_API, x)
+
+PROXY_Trace_t PROXY_Trace = { .Enabled = PROXY_TRACE_ENABLED_DEFAULT };
+
+static PROXY_TraceEntry_t PROXY_TraceRing[PROXY_TRACE_DEPTH];
+static PROXY_PerfMarker_t PROXY_TraceMarkers[PROXY_TRACE_MARKER_DEPTH];
+
+void PROXY_TraceEnable(bool Enable)
+{
+    __atomic_store_n(&PROXY_Trace.Enabled, Enable, __ATOMIC_RELAXED);
+
+    CFE_EVS_SendEventWithAppID(PROXY_TRACE_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: RPC trace %s", Enable ? "enabled" : "disabled");
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_TraceCommit                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Copies a finished call into the next ring slot.                    */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_TraceCommit(PROXY_TraceEntry_t *Entry)
+{
+    uint32 seq = __atomic_fetch_add(&PROXY_Trace.Next, 1, __ATOMIC_RELAXED);
+    PROXY_TraceEntry_t *slot = &PROXY_TraceRing[seq % PROXY_TRACE_DEPTH];
+
+    // Invalidate the slot while it is rewritten
+    __atomic_store_n(&slot->Seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->Function   = Entry->Function;
+    slot->RecvNs     = Entry->RecvNs;
+    slot->DispatchNs = Entry->DispatchNs;
+    slot->CallNs     = Entry->CallNs ? Entry->CallNs : PROXY_MonotonicNs();
+    slot->ReplyNs    = Entry->ReplyNs;
+
+    // Seq is stored one based so that 0 always means invalid
+    __atomic_store_n(&slot->Seq, seq + 1, __ATOMIC_RELEASE);
+
+    Entry->RecvNs = 0;
+} /* End of PROXY_TraceCommit() */
+
+// Keeps a perf marker of the actual app, overwriting the oldest
+void PROXY_TraceMarker(const PROXY_PerfMarker_t *Marker)
+{
+    if (PROXY_TraceOn())
+    {
+        PROXY_TraceMarkers[PROXY_Trace.NextMarker % PROXY_TRACE_MARKER_DEPTH] = *Marker;
+        PROXY_Trace.NextMarker++;
+    }
+}
+
+// Write one complete ("X") event, times in microseconds
+static void PROXY_TraceWriteEvent(FILE *fp, const char *name, const char *cat, uint64 start_ns, uint64 end_ns)
+{
+    fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":1,"
+                "\"ts\":%llu.%03u,\"dur\":%llu.%03u}",
+            name, cat, (int) getpid(),
+            (unsigned long long) (start_ns / 1000), (unsigned int) (start_ns % 1000),
+            (unsigned long long) ((end_ns - start_ns) / 1000), (unsigned int) ((end_ns - start_ns) % 1000));
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_TraceDump                                                    */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Writes the calls in the ring to a Chrome trace JSON file. Each     */
+/*         call is one event, with its decode, cFE and reply phases nested    */
+/*         under it. An empty filename uses PROXY_TRACE_FILE.                 */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_TraceDump(const char *Filename)
+{
+    PROXY_TraceEntry_t entry;
+    FILE  *fp;
+    uint32 next, seq, count = 0, markers = 0;
+    uint64 end_ns;
+
+    if (Filename[0] == '\0')
+    {
+        Filename = PROXY_TRACE_FILE;
+    }
+
+    fp = fopen(Filename, "w");
+    if (fp == NULL)
+    {
+        CFE_EVS_SendEventWithAppID(PROXY_TRACE_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: trace can not open %s: %s", Filename, strerror(errno));
+        return;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    fprintf(fp, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":1,\"args\":{\"name\":\"PROXY\"}}",
+            (int) getpid());
+    fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":2,\"args\":{\"name\":\"ACTUAL\"}}",
+            (int) getpid());
+
+    // Oldest to newest. Calls recorded while dumping may overwrite the oldest slots,
+    // those fail the Seq check and are skipped.
+    next = __atomic_load_n(&PROXY_Trace.Next, __ATOMIC_ACQUIRE);
+    seq  = (next > PROXY_TRACE_DEPTH) ? (next - PROXY_TRACE_DEPTH) : 0;
+    for (; seq != next; seq++)
+    {
+        PROXY_TraceEntry_t *slot = &PROXY_TraceRing[seq % PROXY_TRACE_DEPTH];
+
+        if (__atomic_load_n(&slot->Seq, __ATOMIC_ACQUIRE) != seq + 1)
+        {
+            continue;
+        }
+        entry = *slot;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->Seq, __ATOMIC_RELAXED) != seq + 1)
+        {
+            continue;
+        }
+
+        if (entry.DispatchNs == 0)
+        {
+            // Not a RemoteCall the proxy could decode
+            entry.DispatchNs = entry.RecvNs;
+        }
+        end_ns = entry.ReplyNs ? entry.ReplyNs : entry.CallNs;
+        if (end_ns < entry.DispatchNs)
+        {
+            end_ns = entry.DispatchNs;
+        }
+
+        PROXY_TraceWriteEvent(fp, ns(Function_type_name(entry.Function)), "rpc", entry.RecvNs, end_ns);
+        PROXY_TraceWriteEvent(fp, "decode", "phase", entry.RecvNs, entry.DispatchNs);
+        if (entry.CallNs != 0)
+        {
+            PROXY_TraceWriteEvent(fp, "cfe", "phase", entry.DispatchNs, entry.CallNs);
+        }
+        if (entry.ReplyNs != 0 && entry.CallNs != 0)
+        {
+            PROXY_TraceWriteEvent(fp, "reply", "phase", entry.CallNs, entry.ReplyNs);
+        }
+        count++;
+    }
+
+    // Perf markers as begin / end events, the dump runs on the proxy task like the drain
+    seq = (PROXY_Trace.NextMarker > PROXY_TRACE_MARKER_DEPTH) ? (PROXY_Trace.NextMarker - PROXY_TRACE_MARKER_DEPTH) : 0;
+    for (; seq != PROXY_Trace.NextMarker; seq++)
+    {
+        const PROXY_PerfMarker_t *marker = &PROXY_TraceMarkers[seq % PROXY_TRACE_MARKER_DEPTH];
+
+        fprintf(fp, ",\n{\"name\":\"marker %u\",\"cat\":\"perf\",\"ph\":\"%s\",\"pid\":%d,\"tid\":2,"
+                    "\"ts\":%llu.%03u}",
+                (unsigned int) marker->Marker, marker->EntryExit ? "E" : "B", (int) getpid(),
+                (unsigned long long) (marker->TimeNs / 1000), (unsigned int) (marker->TimeNs % 1000));
+        markers++;
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+
+    CFE_EVS_SendEventWithAppID(PROXY_TRACE_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: dumped %u traced calls and %u perf markers to %s", (unsigned int) count,
+                               (unsigned int) markers, Filename);
+} /* End of PROXY_TraceDump() */
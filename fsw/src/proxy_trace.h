@@ -0,0 +1,103 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_trace_h
+#define proxy_trace_h
+
+#include "proxy.h"
+#include "proxy_ipc.h"
+
+/*
+** One remote call on the proxy timeline. All times are CLOCK_MONOTONIC in ns,
+** zero when the phase did not happen (void functions send no reply).
+*/
+typedef struct
+{
+    uint32  Seq;          // Written last, lets the dump skip slots that are being rewritten
+    uint16  Function;     // Function_* type of the RemoteCall
+    uint16  Spare;
+    uint64  RecvNs;       // nng_recv returned
+    uint64  DispatchNs;   // RemoteCall decoded, about to call cFE
+    uint64  CallNs;       // cFE call returned
+    uint64  ReplyNs;      // reply handed to nng
+} PROXY_TraceEntry_t;
+
+/*
+** Trace state
+**
+** Slots are claimed with an atomic increment of Next, so recording never takes a lock.
+** Each call is built up in the PROXY_TraceEntry_t of the task servicing it and copied
+** into the ring when it ends. Perf markers of the actual app have a ring of their own,
+** only used on the proxy task.
+*/
+typedef struct
+{
+    bool               Enabled;
+    uint32             Next;
+    uint32             NextMarker;
+} PROXY_Trace_t;
+
+extern PROXY_Trace_t PROXY_Trace;
+
+void PROXY_TraceEnable(bool Enable);
+void PROXY_TraceDump(const char *Filename);
+void PROXY_TraceCommit(PROXY_TraceEntry_t *Entry);
+void PROXY_TraceMarker(const PROXY_PerfMarker_t *Marker);
+
+static inline bool PROXY_TraceOn(void)
+{
+    return __atomic_load_n(&PROXY_Trace.Enabled, __ATOMIC_RELAXED);
+}
+
+// RecvNs is when the call came off the socket, which may be before it reaches a worker
+static inline void PROXY_TraceBegin(PROXY_TraceEntry_t *Entry, uint64 RecvNs)
+{
+    if (PROXY_TraceOn())
+    {
+        memset(Entry, 0, sizeof(*Entry));
+        Entry->RecvNs = RecvNs ? RecvNs : PROXY_MonotonicNs();
+    }
+}
+
+static inline void PROXY_TraceDispatch(PROXY_TraceEntry_t *Entry, uint16 Function)
+{
+    if (PROXY_TraceOn())
+    {
+        Entry->Function   = Function;
+        Entry->DispatchNs = PROXY_MonotonicNs();
+    }
+}
+
+static inline void PROXY_TraceCallDone(PROXY_TraceEntry_t *Entry)
+{
+    if (PROXY_TraceOn())
+    {
+        Entry->CallNs = PROXY_MonotonicNs();
+    }
+}
+
+static inline void PROXY_TraceReplySent(PROXY_TraceEntry_t *Entry)
+{
+    if (PROXY_TraceOn())
+    {
+        Entry->ReplyNs = PROXY_MonotonicNs();
+    }
+}
+
+static inline void PROXY_TraceEnd(PROXY_TraceEntry_t *Entry)
+{
+    if (PROXY_TraceOn() && Entry->RecvNs != 0)
+    {
+        PROXY_TraceCommit(Entry);
+    }
+}
+
+#endif /* proxy_trace_h */
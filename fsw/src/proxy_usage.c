@@ -0,0 +1,230 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Resource accounting of the actual app:
+ * getrusage and wait4 only report children that have exited, so the running app is read
+ * from /proc. The stat and status files are opened once per child and read again with
+ * pread, which gives the current values without another open. Sampling is rate limited to
+ * PROXY_USAGE_PERIOD_MS and costs two small reads.
+ *
+ * A limit must be exceeded for PROXY_USAGE_SAMPLES_OVER samples in a row before it is
+ * reported (and acted on, see PROXY_USAGE_ACTION), once per excursion.
+ */
+
+#include "proxy_usage.h"
+#include "proxy_events.h"
+#include "proxy_defs.h"
+
+#include <fcntl.h>
+
+PROXY_Usage_t PROXY_Usage = { .Pid = -1, .StatFd = -1, .StatusFd = -1 };
+
+static long PROXY_UsageTicks;     // clock ticks per second
+static long PROXY_UsagePageKb;    // page size in KiB
+
+static void PROXY_UsageClose(void)
+{
+    if (PROXY_Usage.StatFd >= 0)
+    {
+        close(PROXY_Usage.StatFd);
+    }
+    if (PROXY_Usage.StatusFd >= 0)
+    {
+        close(PROXY_Usage.StatusFd);
+    }
+    PROXY_Usage.StatFd   = -1;
+    PROXY_Usage.StatusFd = -1;
+    PROXY_Usage.Pid      = -1;
+}
+
+// Opens the /proc files of the current actual app, returns false if there is none
+static bool PROXY_UsageOpen(void)
+{
+    char path[64];
+
+    if (PROXY_Usage.Pid == childPID && PROXY_Usage.StatFd >= 0)
+    {
+        return true;
+    }
+
+    PROXY_UsageClose();
+    if (childPID <= 0)
+    {
+        return false;
+    }
+
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int) childPID);
+    PROXY_Usage.StatFd = open(path, O_RDONLY | O_CLOEXEC);
+    snprintf(path, sizeof(path), "/proc/%d/status", (int) childPID);
+    PROXY_Usage.StatusFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (PROXY_Usage.StatFd < 0 || PROXY_Usage.StatusFd < 0)
+    {
+        PROXY_UsageClose();
+        return false;
+    }
+
+    PROXY_Usage.Pid      = childPID;
+    PROXY_Usage.SampleNs = 0;
+    PROXY_Usage.CpuPct   = 0;
+    PROXY_Usage.Over     = 0;
+    PROXY_Usage.Alarm    = false;
+
+    return true;
+}
+
+// Reads a whole /proc file from the start into Buffer, returns false when the process is gone
+static bool PROXY_UsageRead(int Fd, char *Buffer, size_t Size)
+{
+    ssize_t got = pread(Fd, Buffer, Size - 1, 0);
+
+    if (got <= 0)
+    {
+        return false;
+    }
+    Buffer[got] = '\0';
+
+    return true;
+}
+
+static uint32 PROXY_UsageStatusField(const char *Status, const char *Name)
+{
+    const char *field = strstr(Status, Name);
+
+    return field != NULL ? (uint32) strtoul(field + strlen(Name), NULL, 10) : 0;
+}
+
+// Checks the limits against the last sample
+static void PROXY_UsageCheckLimits(void)
+{
+    bool over_cpu = PROXY_Usage.CpuPctMax != 0 && PROXY_Usage.CpuPct > PROXY_Usage.CpuPctMax;
+    bool over_rss = PROXY_Usage.RssKbMax != 0 && PROXY_Usage.RssKb > PROXY_Usage.RssKbMax;
+
+    if (!over_cpu && !over_rss)
+    {
+        if (PROXY_Usage.Alarm)
+        {
+            CFE_EVS_SendEventWithAppID(PROXY_USAGE_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                                       "PROXY: actual app back within limits, cpu %u%%, rss %u KiB",
+                                       (unsigned int) PROXY_Usage.CpuPct, (unsigned int) PROXY_Usage.RssKb);
+        }
+        PROXY_Usage.Over  = 0;
+        PROXY_Usage.Alarm = false;
+        return;
+    }
+
+    PROXY_Usage.Over++;
+    if (PROXY_Usage.Alarm || PROXY_Usage.Over < PROXY_USAGE_SAMPLES_OVER)
+    {
+        return;
+    }
+
+    PROXY_Usage.Alarm = true;
+    PROXY_Usage.Alarms++;
+    CFE_EVS_SendEventWithAppID(PROXY_USAGE_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                               "PROXY: actual app pid %d over limit%s: cpu %u%% (max %u), rss %u KiB (max %u)",
+                               (int) PROXY_Usage.Pid, PROXY_USAGE_ACTION == PROXY_USAGE_RESTART ? ", restarting" : "",
+                               (unsigned int) PROXY_Usage.CpuPct, (unsigned int) PROXY_Usage.CpuPctMax,
+                               (unsigned int) PROXY_Usage.RssKb, (unsigned int) PROXY_Usage.RssKbMax);
+
+    if (PROXY_USAGE_ACTION == PROXY_USAGE_RESTART)
+    {
+        PROXY_RestartChild();
+    }
+}
+
+void PROXY_UsageInit(void)
+{
+    PROXY_UsageTicks  = sysconf(_SC_CLK_TCK);
+    PROXY_UsagePageKb = sysconf(_SC_PAGESIZE) / 1024;
+
+    PROXY_Usage.CpuPctMax = PROXY_USAGE_CPU_PCT_MAX;
+    PROXY_Usage.RssKbMax  = PROXY_USAGE_RSS_KB_MAX;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_UsageSample                                                  */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Samples the resources of the actual app, at most every             */
+/*         PROXY_USAGE_PERIOD_MS, and checks the limits.                      */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_UsageSample(void)
+{
+    char          buffer[4096];
+    const char   *fields;
+    unsigned long minflt, majflt, utime, stime;
+    long          rss;
+    uint64        now = PROXY_MonotonicNs();
+    uint64        ticks;
+
+    if (PROXY_Usage.SampleNs != 0 && PROXY_Usage.Pid == childPID &&
+        now - PROXY_Usage.SampleNs < (uint64) PROXY_USAGE_PERIOD_MS * 1000000)
+    {
+        return;
+    }
+
+    if (!PROXY_UsageOpen() || !PROXY_UsageRead(PROXY_Usage.StatFd, buffer, sizeof(buffer)))
+    {
+        // No app, or it exited and the restart has not happened yet
+        PROXY_UsageClose();
+        return;
+    }
+
+    // The command name may hold spaces and parentheses, the fields start after the last ')'
+    fields = strrchr(buffer, ')');
+    if (fields == NULL ||
+        sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %lu %*u %lu %*u %lu %lu %*d %*d %*d %*d %*d %*d %*u %*u %ld",
+               &minflt, &majflt, &utime, &stime, &rss) != 5)
+    {
+        return;
+    }
+
+    ticks = utime + stime;
+    if (PROXY_Usage.SampleNs != 0 && now > PROXY_Usage.SampleNs)
+    {
+        PROXY_Usage.CpuPct = ((ticks - PROXY_Usage.CpuTicks) * 100000000000ULL / PROXY_UsageTicks) /
+                             (now - PROXY_Usage.SampleNs);
+    }
+    PROXY_Usage.CpuTicks  = ticks;
+    PROXY_Usage.SampleNs  = now;
+    PROXY_Usage.UtimeMs   = (uint64) utime * 1000 / PROXY_UsageTicks;
+    PROXY_Usage.StimeMs   = (uint64) stime * 1000 / PROXY_UsageTicks;
+    PROXY_Usage.RssKb     = rss * PROXY_UsagePageKb;
+    PROXY_Usage.MinFaults = minflt;
+    PROXY_Usage.MajFaults = majflt;
+
+    if (PROXY_UsageRead(PROXY_Usage.StatusFd, buffer, sizeof(buffer)))
+    {
+        PROXY_Usage.VolCtxSwitches   = PROXY_UsageStatusField(buffer, "\nvoluntary_ctxt_switches:");
+        PROXY_Usage.InvolCtxSwitches = PROXY_UsageStatusField(buffer, "\nnonvoluntary_ctxt_switches:");
+    }
+
+    PROXY_UsageCheckLimits();
+} /* End of PROXY_UsageSample() */
+
+// Ground command, 0 disables a limit
+void PROXY_UsageSetLimits(uint32 CpuPctMax, uint32 RssKbMax)
+{
+    PROXY_Usage.CpuPctMax = CpuPctMax;
+    PROXY_Usage.RssKbMax  = RssKbMax;
+    PROXY_Usage.Over      = 0;
+    PROXY_Usage.Alarm     = false;
+
+    CFE_EVS_SendEventWithAppID(PROXY_USAGE_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: actual app limits cpu %u%%, rss %u KiB", (unsigned int) CpuPctMax,
+                               (unsigned int) RssKbMax);
+}
+
+void PROXY_UsageCleanup(void)
+{
+    PROXY_UsageClose();
+}
@@ -0,0 +1,58 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_usage_h
+#define proxy_usage_h
+
+#include "proxy.h"
+
+/* What to do when the actual app stays over a limit (PROXY_USAGE_ACTION) */
+#define PROXY_USAGE_EVENT       0   /* send an event */
+#define PROXY_USAGE_RESTART     1   /* send an event and restart the actual app */
+
+/*
+** Resources used by the actual app, sampled from /proc every PROXY_USAGE_PERIOD_MS. Only
+** used on the proxy task.
+*/
+typedef struct
+{
+    pid_t   Pid;              // process the files are open for
+    int     StatFd;           // /proc/<pid>/stat, kept open and read with pread
+    int     StatusFd;         // /proc/<pid>/status, for the context switches
+    uint64  SampleNs;         // time of the last sample
+    uint64  CpuTicks;         // user + system time at the last sample
+
+    // Last sample
+    uint32  CpuPct;           // percent of one CPU since the sample before
+    uint32  UtimeMs;
+    uint32  StimeMs;
+    uint32  RssKb;
+    uint32  MinFaults;
+    uint32  MajFaults;
+    uint32  VolCtxSwitches;
+    uint32  InvolCtxSwitches;
+
+    // Limits, 0 disables
+    uint32  CpuPctMax;
+    uint32  RssKbMax;
+    uint32  Over;             // consecutive samples over a limit
+    bool    Alarm;            // reported for the current excursion
+    uint32  Alarms;           // excursions reported
+} PROXY_Usage_t;
+
+extern PROXY_Usage_t PROXY_Usage;
+
+void PROXY_UsageInit(void);
+void PROXY_UsageSample(void);
+void PROXY_UsageSetLimits(uint32 CpuPctMax, uint32 RssKbMax);
+void PROXY_UsageCleanup(void);
+
+#endif /* proxy_usage_h */
@@ -0,0 +1,208 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * Wait strategies for the free running loop (not used in PROXY_SCHEDULED_MODE):
+ *
+ * PROXY_WAIT_BLOCKING  - nng_recv waits up to ACTUAL_NNG_TIMEOUT. Near zero idle CPU, the
+ *                        wakeup latency is whatever the OS and nng give a blocked thread.
+ * PROXY_WAIT_BUSY_POLL - non-blocking nng_recv on every pass of the run loop. Burns a core,
+ *                        a message is seen within one pass of the loop.
+ * PROXY_WAIT_HYBRID    - spins for an adaptive budget, then blocks. The budget doubles when a
+ *                        message arrives shortly after giving up on the spin, and halves when
+ *                        blocking finds nothing for a long time.
+ */
+
+#include "proxy_wait.h"
+#include "proxy_events.h"
+#include "proxy_defs.h"
+
+#include <nng/nng.h>
+
+PROXY_Wait_t PROXY_Wait;
+
+static uint64 PROXY_ThreadCpuNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return ((uint64) now.tv_sec * 1000000000) + now.tv_nsec;
+}
+
+void PROXY_WaitInit(void)
+{
+    memset(&PROXY_Wait, 0, sizeof(PROXY_Wait));
+    PROXY_Wait.Strategy     = PROXY_WAIT_STRATEGY_DEFAULT;
+    PROXY_Wait.SpinMaxUs    = PROXY_WAIT_SPIN_MAX_US;
+    PROXY_Wait.SpinBudgetUs = PROXY_WAIT_SPIN_MIN_US;
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_WaitSetStrategy                                              */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Selects the wait strategy and clears its statistics. A SpinMaxUs   */
+/*         of zero keeps the current spin limit.                              */
+/* * * * * * * * * * * * * * * * * * * * * * * *  * * * * * * *  * *  * * * * */
+void PROXY_WaitSetStrategy(uint8 Strategy, uint32 SpinMaxUs)
+{
+    uint32 SpinMax = SpinMaxUs ? SpinMaxUs : PROXY_Wait.SpinMaxUs;
+
+    if (Strategy > PROXY_WAIT_HYBRID || SpinMax < PROXY_WAIT_SPIN_MIN_US)
+    {
+        PROXY_HkTelemetryPkt.proxy_command_error_count++;
+        CFE_EVS_SendEventWithAppID(PROXY_COMMAND_ERR_EID, CFE_EVS_EventType_ERROR, proxy_evs_id,
+                                   "PROXY: invalid wait strategy %u, spin max %u us",
+                                   (unsigned int) Strategy, (unsigned int) SpinMax);
+        return;
+    }
+
+    memset(&PROXY_Wait, 0, sizeof(PROXY_Wait));
+    PROXY_Wait.Strategy     = Strategy;
+    PROXY_Wait.SpinMaxUs    = SpinMax;
+    PROXY_Wait.SpinBudgetUs = PROXY_WAIT_SPIN_MIN_US;
+
+    CFE_EVS_SendEventWithAppID(PROXY_WAIT_INF_EID, CFE_EVS_EventType_INFORMATION, proxy_evs_id,
+                               "PROXY: wait strategy %u, spin max %u us",
+                               (unsigned int) Strategy, (unsigned int) SpinMax);
+} /* End of PROXY_WaitSetStrategy() */
+
+// A non-blocking receive that also tracks the gap since the previous poll. Errors are not
+// reported here: on one the caller falls back to PROXY_WaitBlock, which reports it at the
+// pace of the blocking strategy instead of at spin rate.
+static int PROXY_WaitPoll(char **buffer, size_t *sz)
+{
+    uint64 now = PROXY_MonotonicNs();
+
+    if (PROXY_Wait.LastPollNs != 0 && now - PROXY_Wait.LastPollNs > PROXY_Wait.PollGapMaxNs)
+    {
+        PROXY_Wait.PollGapMaxNs = now - PROXY_Wait.LastPollNs;
+    }
+    PROXY_Wait.LastPollNs = now;
+
+    return nng_recv(sock, buffer, sz, NNG_FLAG_ALLOC | NNG_FLAG_NONBLOCK);
+}
+
+// A blocking receive, as PROXY_WAIT_BLOCKING does
+static int PROXY_WaitBlock(char **buffer, size_t *sz)
+{
+    int rv = receive_message(0, buffer, sz);
+
+    if (rv == 0)
+    {
+        PROXY_Wait.BlockHits++;
+    }
+    else if (rv == NNG_ETIMEDOUT)
+    {
+        PROXY_Wait.Timeouts++;
+    }
+
+    return rv;
+}
+
+static void PROXY_WaitGrowSpin(void)
+{
+    PROXY_Wait.SpinBudgetUs *= 2;
+    if (PROXY_Wait.SpinBudgetUs > PROXY_Wait.SpinMaxUs)
+    {
+        PROXY_Wait.SpinBudgetUs = PROXY_Wait.SpinMaxUs;
+    }
+}
+
+static void PROXY_WaitShrinkSpin(void)
+{
+    PROXY_Wait.SpinBudgetUs /= 2;
+    if (PROXY_Wait.SpinBudgetUs < PROXY_WAIT_SPIN_MIN_US)
+    {
+        PROXY_Wait.SpinBudgetUs = PROXY_WAIT_SPIN_MIN_US;
+    }
+}
+
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+/*  Name:  PROXY_WaitAndService                                               */
+/*                                                                            */
+/*  Purpose:                                                                  */
+/*         Waits for one remote call using the selected strategy and services */
+/*         it. Called once per pass of the free running loop.                 */
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * **/
+void PROXY_WaitAndService(void)
+{
+    char  *buffer = NULL;
+    size_t sz;
+    int    rv;
+    uint64 wall_start = PROXY_MonotonicNs();
+    uint64 cpu_start  = PROXY_ThreadCpuNs();
+    uint64 spin_end, block_start, waited;
+
+    switch (PROXY_Wait.Strategy)
+    {
+        case PROXY_WAIT_BUSY_POLL:
+            rv = PROXY_WaitPoll(&buffer, &sz);
+            if (rv == 0)
+            {
+                PROXY_Wait.SpinHits++;
+            }
+            else if (rv != NNG_EAGAIN)
+            {
+                rv = PROXY_WaitBlock(&buffer, &sz);
+            }
+            break;
+
+        case PROXY_WAIT_HYBRID:
+            spin_end = wall_start + ((uint64) PROXY_Wait.SpinBudgetUs * 1000);
+            PROXY_Wait.LastPollNs = 0;
+            do
+            {
+                rv = PROXY_WaitPoll(&buffer, &sz);
+            } while (rv == NNG_EAGAIN && PROXY_MonotonicNs() < spin_end);
+
+            if (rv == 0)
+            {
+                PROXY_Wait.SpinHits++;
+                break;
+            }
+
+            // Nothing within the spin budget, or an error that spinning would only repeat
+            block_start = PROXY_MonotonicNs();
+            rv = PROXY_WaitBlock(&buffer, &sz);
+            waited = PROXY_MonotonicNs() - block_start;
+            if (rv == 0)
+            {
+                // Just missed it: a longer spin would have caught this one
+                if (waited < (uint64) PROXY_Wait.SpinBudgetUs * 1000)
+                {
+                    PROXY_WaitGrowSpin();
+                }
+                else
+                {
+                    PROXY_WaitShrinkSpin();
+                }
+            }
+            else if (rv == NNG_ETIMEDOUT)
+            {
+                PROXY_WaitShrinkSpin();
+            }
+            break;
+
+        case PROXY_WAIT_BLOCKING:
+        default:
+            rv = PROXY_WaitBlock(&buffer, &sz);
+            break;
+    }
+
+    PROXY_Wait.IdleWallNs += PROXY_MonotonicNs() - wall_start;
+    PROXY_Wait.IdleCpuNs  += PROXY_ThreadCpuNs() - cpu_start;
+
+    if (rv == 0)
+    {
+        process_message(buffer, sz);
+    }
+} /* End of PROXY_WaitAndService() */
@@ -0,0 +1,43 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+#ifndef proxy_wait_h
+#define proxy_wait_h
+
+#include "proxy.h"
+
+/*
+** Wait strategy state and statistics. The statistics are cleared when the
+** strategy changes, so housekeeping always describes the current strategy.
+*/
+typedef struct
+{
+    uint8   Strategy;         // PROXY_WAIT_* from proxy_msg.h
+    uint32  SpinBudgetUs;     // Current (adaptive) spin time before blocking, hybrid only
+    uint32  SpinMaxUs;
+
+    uint32  SpinHits;         // Messages found without blocking
+    uint32  BlockHits;        // Messages that arrived while blocked in nng_recv
+    uint32  Timeouts;         // Blocking waits that timed out
+
+    uint64  IdleWallNs;       // Time spent waiting for the actual app
+    uint64  IdleCpuNs;        // Proxy CPU time burned while waiting
+    uint64  PollGapMaxNs;     // Longest gap between two polls, the worst case wakeup latency of a spin hit
+    uint64  LastPollNs;
+} PROXY_Wait_t;
+
+extern PROXY_Wait_t PROXY_Wait;
+
+void PROXY_WaitInit(void);
+void PROXY_WaitSetStrategy(uint8 Strategy, uint32 SpinMaxUs);
+void PROXY_WaitAndService(void);
+
+#endif /* proxy_wait_h */
@@ -0,0 +1,259 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * proxy_replay: feeds a capture made with PROXY_RECORD_START_CC back into a proxy.
+ *
+ * The tool takes the place of the actual app: it dials the proxy IPC address and sends
+ * every recorded RemoteCall in order. Each request record says how many replies the proxy
+ * sends for it (none for void calls like PerfLogAdd, one per call of a batch), the tool waits
+ * for those. A reply that times out may still come, so after a timeout the late replies
+ * are drained before the next call, rather than being taken as its answers. Calls are paced
+ * as recorded, or sent back to back with -m, and the throughput and reply latency are
+ * printed at the end.
+ *
+ * Usage: proxy_replay [-m] [-a address] [-n max_calls] [-t timeout_ms] capture.bin
+ *
+ * The address is relative to the working directory, like the proxy and client ones.
+ * Note a capture that ends with ExitApp will shut the proxy down; use -n to stop short.
+ */
+
+#include "proxy_record_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nng/nng.h>
+#include <nng/protocol/pair0/pair.h>
+
+#define DEFAULT_ADDRESS    "ipc://./cf/pair.ipc"
+#define DEFAULT_TIMEOUT_MS 1000
+
+typedef struct
+{
+    PROXY_RecordHdr_t Hdr;
+    void             *Data;
+} frame_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000) + now.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+// Reads the next record, returns 0 at the end of the file
+static int read_frame(FILE *fp, frame_t *frame)
+{
+    if (fread(&frame->Hdr, sizeof(frame->Hdr), 1, fp) != 1)
+    {
+        return 0;
+    }
+
+    frame->Data = malloc(frame->Hdr.Length ? frame->Hdr.Length : 1);
+    if (frame->Data == NULL || fread(frame->Data, 1, frame->Hdr.Length, fp) != frame->Hdr.Length)
+    {
+        fprintf(stderr, "Truncated record\n");
+        free(frame->Data);
+        return 0;
+    }
+
+    return 1;
+}
+
+// Discards up to count late replies of a call that timed out, each waited for as long as a reply
+static void drain_replies(nng_socket sock, uint16_t count)
+{
+    char  *reply;
+    size_t reply_size;
+
+    while (count-- > 0 && nng_recv(sock, &reply, &reply_size, NNG_FLAG_ALLOC) == 0)
+    {
+        nng_free(reply, reply_size);
+    }
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-m] [-a address] [-n max_calls] [-t timeout_ms] capture.bin\n", name);
+    fprintf(stderr, "  -m  send at maximum speed instead of the recorded pacing\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *address = DEFAULT_ADDRESS;
+    int         max_speed = 0;
+    long        max_calls = -1;
+    int         timeout_ms = DEFAULT_TIMEOUT_MS;
+    int         opt, rv;
+
+    PROXY_RecordFileHdr_t file_hdr;
+    frame_t     frame;
+    FILE       *fp;
+    nng_socket  sock;
+    uint16_t    pending;
+
+    uint64_t   *latencies = NULL;
+    size_t      latency_count = 0, latency_size = 0;
+    long        calls = 0, timeouts = 0;
+    uint64_t    first_record_ns = 0, start_ns = 0, end_ns, target_ns;
+
+    while ((opt = getopt(argc, argv, "ma:n:t:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'm': max_speed = 1; break;
+            case 'a': address = optarg; break;
+            case 'n': max_calls = atol(optarg); break;
+            case 't': timeout_ms = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1)
+    {
+        usage(argv[0]);
+    }
+
+    fp = fopen(argv[optind], "rb");
+    if (fp == NULL)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (fread(&file_hdr, sizeof(file_hdr), 1, fp) != 1 ||
+        file_hdr.Magic != PROXY_RECORD_MAGIC || file_hdr.Version != PROXY_RECORD_VERSION)
+    {
+        fprintf(stderr, "%s is not a proxy capture (or is a different version)\n", argv[optind]);
+        return 1;
+    }
+
+    if ((rv = nng_pair0_open(&sock)) != 0 ||
+        (rv = nng_setopt_ms(sock, NNG_OPT_RECVTIMEO, timeout_ms)) != 0 ||
+        (rv = nng_dial(sock, address, NULL, 0)) != 0)
+    {
+        fprintf(stderr, "Can not connect to %s: %s\n", address, nng_strerror(rv));
+        return 1;
+    }
+
+    while (max_calls != 0 && read_frame(fp, &frame))
+    {
+        if (frame.Hdr.Kind != PROXY_RECORD_REQUEST)
+        {
+            // The recorded replies are not compared, the proxy state may differ
+            free(frame.Data);
+            continue;
+        }
+
+        if (start_ns == 0)
+        {
+            first_record_ns = frame.Hdr.TimeNs;
+            start_ns = now_ns();
+        }
+        else if (!max_speed)
+        {
+            target_ns = start_ns + (frame.Hdr.TimeNs - first_record_ns);
+            while (now_ns() < target_ns)
+            {
+                // Short sleeps keep the pacing close without burning a core
+                usleep(50);
+            }
+        }
+
+        uint64_t sent_ns = now_ns();
+        if ((rv = nng_send(sock, frame.Data, frame.Hdr.Length, 0)) != 0)
+        {
+            fprintf(stderr, "Send failed: %s\n", nng_strerror(rv));
+            free(frame.Data);
+            break;
+        }
+        free(frame.Data);
+        calls++;
+        if (max_calls > 0)
+        {
+            max_calls--;
+        }
+
+        for (pending = frame.Hdr.Replies; pending > 0; pending--)
+        {
+            char  *reply;
+            size_t reply_size;
+
+            rv = nng_recv(sock, &reply, &reply_size, NNG_FLAG_ALLOC);
+            if (rv == 0)
+            {
+                if (latency_count == latency_size)
+                {
+                    latency_size = latency_size ? latency_size * 2 : 1024;
+                    latencies = realloc(latencies, latency_size * sizeof(*latencies));
+                }
+                latencies[latency_count++] = now_ns() - sent_ns;
+                nng_free(reply, reply_size);
+            }
+            else if (rv == NNG_ETIMEDOUT)
+            {
+                timeouts += pending;
+                drain_replies(sock, pending);
+                break;
+            }
+            else
+            {
+                fprintf(stderr, "Receive failed: %s\n", nng_strerror(rv));
+                max_calls = 0;      // ends the replay
+                break;
+            }
+        }
+    }
+    end_ns = now_ns();
+
+    printf("Calls sent:      %ld\n", calls);
+    printf("Replies:         %zu (%ld timed out)\n", latency_count, timeouts);
+    if (calls > 0 && end_ns > start_ns)
+    {
+        double seconds = (end_ns - start_ns) / 1e9;
+        printf("Elapsed:         %.3f s\n", seconds);
+        printf("Throughput:      %.1f calls/s\n", calls / seconds);
+    }
+    if (latency_count > 0)
+    {
+        uint64_t sum = 0;
+        size_t   index;
+
+        qsort(latencies, latency_count, sizeof(*latencies), compare_u64);
+        for (index = 0; index < latency_count; index++)
+        {
+            sum += latencies[index];
+        }
+        printf("Latency (us):    min %.1f  avg %.1f  p50 %.1f  p99 %.1f  max %.1f\n",
+               latencies[0] / 1e3,
+               (double) sum / latency_count / 1e3,
+               latencies[latency_count / 2] / 1e3,
+               latencies[(latency_count * 99) / 100] / 1e3,
+               latencies[latency_count - 1] / 1e3);
+    }
+
+    free(latencies);
+    nng_close(sock);
+    fclose(fp);
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+** GSC-18364-1, "Proxy Core Flight System Application and Client for External Process"
+**
+** Copyright © 2019-2022 United States Government as represented by
+** the Administrator of the National Aeronautics and Space Administration.
+** All Rights Reserved.
+**
+** Licensed under the NASA Open Source Agreement version 1.3
+** See "NOSA GSC-18364-1.pdf"
+*/
+
+/*
+ * proxy_stat: samples the statistics page of a running proxy.
+ *
+ * The page is mapped read-only, so sampling costs the proxy nothing and does not touch the
+ * Software Bus. Each line shows the state of the actual app, the rates since the previous
+ * sample and the call latency; -H adds the latency histogram of the interval.
+ *
+ * Usage: proxy_stat [-H] [-n shm_name] [-i interval_ms] [-c count]
+ */
+
+#include "proxy_stats_page.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_NAME        "/proxy_stats"
+#define DEFAULT_INTERVAL_MS 1000
+
+static uint64_t now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000) + now.tv_nsec;
+}
+
+// Copies the page: counters as they are, the state block under the sequence lock
+static void snapshot(const PROXY_StatsPage_t *page, PROXY_StatsPage_t *copy)
+{
+    uint32_t seq;
+
+    do
+    {
+        while ((seq = __atomic_load_n(&page->Sequence, __ATOMIC_ACQUIRE)) & 1)
+        {
+            // The proxy is publishing, it takes microseconds
+        }
+        memcpy(copy, page, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&page->Sequence, __ATOMIC_RELAXED) != seq);
+}
+
+static const char *child_state(int32_t state)
+{
+    switch (state)
+    {
+        case PROXY_STATS_CHILD_RUNNING:   return "running";
+        case PROXY_STATS_CHILD_TIMED_OUT: return "timeout";
+        case PROXY_STATS_CHILD_EXITED:    return "exited";
+        default:                          return "unknown";
+    }
+}
+
+// Upper bound in us of the bucket holding the given fraction of the interval's calls
+static uint64_t percentile_us(const uint64_t *hist, uint64_t total, double fraction)
+{
+    uint64_t seen = 0;
+    int      bucket;
+
+    for (bucket = 0; bucket < PROXY_STATS_LATENCY_BUCKETS; bucket++)
+    {
+        seen += hist[bucket];
+        if (seen >= total * fraction)
+        {
+            break;
+        }
+    }
+
+    return (uint64_t) 1 << (bucket < PROXY_STATS_LATENCY_BUCKETS ? bucket : PROXY_STATS_LATENCY_BUCKETS - 1);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-H] [-n shm_name] [-i interval_ms] [-c count]\n", name);
+    fprintf(stderr, "  -H  print the latency histogram of each interval\n");
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *name = DEFAULT_NAME;
+    long        interval_ms = DEFAULT_INTERVAL_MS;
+    long        count = 0, samples = 0;
+    int         histogram = 0;
+    int         opt, fd, bucket;
+
+    const PROXY_StatsPage_t *page;
+    PROXY_StatsPage_t prev, cur;
+    uint64_t    hist[PROXY_STATS_LATENCY_BUCKETS];
+    uint64_t    prev_ns, cur_ns, calls;
+    double      seconds;
+
+    while ((opt = getopt(argc, argv, "Hn:i:c:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'H': histogram = 1; break;
+            case 'n': name = optarg; break;
+            case 'i': interval_ms = atol(optarg); break;
+            case 'c': count = atol(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || interval_ms <= 0)
+    {
+        usage(argv[0]);
+    }
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        perror(name);
+        return 1;
+    }
+    page = mmap(NULL, sizeof(*page), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (page == MAP_FAILED)
+    {
+        perror("mmap");
+        return 1;
+    }
+    if (__atomic_load_n(&page->Magic, __ATOMIC_ACQUIRE) != PROXY_STATS_MAGIC ||
+        page->Version != PROXY_STATS_VERSION || page->Size != sizeof(*page))
+    {
+        fprintf(stderr, "%s is not a proxy statistics page (or is a different version)\n", name);
+        return 1;
+    }
+
+    printf("proxy pid %u\n", (unsigned int) page->ProxyPid);
+    printf("%-8s %7s %9s %9s %9s %8s %8s %8s %8s %8s %6s %6s %5s\n", "child", "pid", "age_ms", "calls/s",
+           "replies/s", "avg_us", "p50_us", "p99_us", "max_us", "out_B", "drops", "pool", "rst");
+
+    snapshot(page, &prev);
+    prev_ns = now_ns();
+    while (count == 0 || samples++ < count)
+    {
+        usleep(interval_ms * 1000);
+
+        snapshot(page, &cur);
+        cur_ns  = now_ns();
+        seconds = (cur_ns - prev_ns) / 1e9;
+
+        calls = cur.LatencyCount - prev.LatencyCount;
+        for (bucket = 0; bucket < PROXY_STATS_LATENCY_BUCKETS; bucket++)
+        {
+            hist[bucket] = cur.LatencyHist[bucket] - prev.LatencyHist[bucket];
+        }
+
+        printf("%-8s %7d %9.1f %9.0f %9.0f %8.1f %8lu %8lu %8.1f %8u %6u %6u %5u\n", child_state(cur.ChildState),
+               (int) cur.ChildPid, cur.LastMsgNs ? (cur_ns - cur.LastMsgNs) / 1e6 : -1.0,
+               (cur.Calls - prev.Calls) / seconds, (cur.Replies - prev.Replies) / seconds,
+               calls ? (cur.LatencySumNs - prev.LatencySumNs) / 1e3 / calls : 0.0,
+               calls ? (unsigned long) percentile_us(hist, calls, 0.50) : 0UL,
+               calls ? (unsigned long) percentile_us(hist, calls, 0.99) : 0UL, cur.LatencyMaxNs / 1e3,
+               (unsigned int) cur.OutQueuedBytes, (unsigned int) cur.OutDrops, (unsigned int) cur.PoolDepth,
+               (unsigned int) cur.ChildRestarts);
+
+        if (cur.NngError != prev.NngError || cur.OutError != prev.OutError || cur.LaunchStage != prev.LaunchStage)
+        {
+            printf("  errors: nng %d, send %d, launch stage %d (errno %d)\n", (int) cur.NngError, (int) cur.OutError,
+                   (int) cur.LaunchStage, (int) cur.ForkError);
+        }
+
+        if (histogram && calls)
+        {
+            for (bucket = 0; bucket < PROXY_STATS_LATENCY_BUCKETS; bucket++)
+            {
+                if (hist[bucket])
+                {
+                    printf("  %s%6lu us %10lu\n", bucket == PROXY_STATS_LATENCY_BUCKETS - 1 ? ">=" : "< ",
+                           (unsigned long) 1 << (bucket == PROXY_STATS_LATENCY_BUCKETS - 1 ? bucket - 1 : bucket),
+                           (unsigned long) hist[bucket]);
+                }
+            }
+        }
+        fflush(stdout);
+
+        prev    = cur;
+        prev_ns = cur_ns;
+    }
+
+    return 0;
+}